@@ -0,0 +1,390 @@
+/****************************************************************************
+ * Snes9x Nintendo Wii/Gamecube Port
+ *
+ * Tantric 2008-2023
+ *
+ * langtab.c
+ *
+ * Build tool - compiles a .lang file into the perfect hash table that
+ * gettext.cpp looks translations up in (see source/utils/langtab.h)
+ *
+ * usage: langtab <in.lang> <out.langtab>
+ ***************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../source/utils/langtab.h"
+
+#define MAX_DISP	(1 << 24)
+
+typedef struct
+{
+	uint32_t id;
+	char * msgstr;
+} MSG;
+
+static MSG * msgs = NULL;
+static int msgCount = 0;
+
+/* Expand some escape sequences found in the argument string.  */
+static char *
+expand_escape(const char *str)
+{
+	char *retval, *rp;
+	const char *cp = str;
+
+	retval = (char *) malloc(strlen(str) + 1);
+	if (retval == NULL)
+		return NULL;
+	rp = retval;
+
+	while (cp[0] != '\0' && cp[0] != '\\')
+		*rp++ = *cp++;
+	if (cp[0] == '\0')
+		goto terminate;
+	do
+	{
+
+		/* Here cp[0] == '\\'.  */
+		switch (*++cp)
+		{
+		case '\"': /* " */
+			*rp++ = '\"';
+			++cp;
+			break;
+		case 'a': /* alert */
+			*rp++ = '\a';
+			++cp;
+			break;
+		case 'b': /* backspace */
+			*rp++ = '\b';
+			++cp;
+			break;
+		case 'f': /* form feed */
+			*rp++ = '\f';
+			++cp;
+			break;
+		case 'n': /* new line */
+			*rp++ = '\n';
+			++cp;
+			break;
+		case 'r': /* carriage return */
+			*rp++ = '\r';
+			++cp;
+			break;
+		case 't': /* horizontal tab */
+			*rp++ = '\t';
+			++cp;
+			break;
+		case 'v': /* vertical tab */
+			*rp++ = '\v';
+			++cp;
+			break;
+		case '\\':
+			*rp = '\\';
+			++cp;
+			break;
+		case '0':
+		case '1':
+		case '2':
+		case '3':
+		case '4':
+		case '5':
+		case '6':
+		case '7':
+		{
+			int ch = *cp++ - '0';
+
+			if (*cp >= '0' && *cp <= '7')
+			{
+				ch *= 8;
+				ch += *cp++ - '0';
+
+				if (*cp >= '0' && *cp <= '7')
+				{
+					ch *= 8;
+					ch += *cp++ - '0';
+				}
+			}
+			*rp = ch;
+		}
+			break;
+		default:
+			*rp = '\\';
+			break;
+		}
+
+		while (cp[0] != '\0' && cp[0] != '\\')
+			*rp++ = *cp++;
+	} while (cp[0] != '\0');
+
+	/* Terminate string.  */
+	terminate: *rp = '\0';
+	return retval;
+}
+
+// msgids with the same hash share one translation, the last one wins
+static void setMSG(const char *msgid, const char *msgstr)
+{
+	uint32_t id = LangTabHash(msgid);
+	int i;
+
+	for (i = 0; i < msgCount; i++)
+	{
+		if (msgs[i].id == id)
+			break;
+	}
+
+	if (i == msgCount)
+	{
+		msgs = (MSG *) realloc(msgs, (msgCount + 1) * sizeof(MSG));
+		msgs[i].id = id;
+		msgs[i].msgstr = NULL;
+		msgCount++;
+	}
+
+	free(msgs[i].msgstr);
+	msgs[i].msgstr = expand_escape(msgstr);
+}
+
+// Reads the msgid/msgstr pairs the same way the runtime parser used to
+static void ParseLanguage(char * file, char * eof)
+{
+	char *lastID = NULL;
+
+	while (file < eof)
+	{
+		char *line = file;
+		char *newline = (char *) memchr(file, '\n', eof - file);
+
+		if (newline == NULL)
+			break;
+
+		*newline = 0;
+		file = newline + 1;
+
+		// lines starting with # are comments
+		if (line[0] == '#')
+			continue;
+
+		if (strncmp(line, "msgid \"", 7) == 0)
+		{
+			char *msgid, *end;
+			free(lastID);
+			lastID = NULL;
+
+			msgid = &line[7];
+			end = strrchr(msgid, '"');
+			if (end && end - msgid > 1)
+			{
+				*end = 0;
+				lastID = strdup(msgid);
+			}
+		}
+		else if (strncmp(line, "msgstr \"", 8) == 0)
+		{
+			char *msgstr, *end;
+
+			if (lastID == NULL)
+				continue;
+
+			msgstr = &line[8];
+			end = strrchr(msgstr, '"');
+			if (end && end - msgstr > 1)
+			{
+				*end = 0;
+				setMSG(lastID, msgstr);
+			}
+			free(lastID);
+			lastID = NULL;
+		}
+	}
+	free(lastID);
+}
+
+static void Write32(unsigned char * p, uint32_t v)
+{
+	p[0] = v >> 24;
+	p[1] = v >> 16;
+	p[2] = v >> 8;
+	p[3] = v;
+}
+
+static int * bucketSize;
+
+static int CompareBuckets(const void * a, const void * b)
+{
+	return bucketSize[*(const int *)b] - bucketSize[*(const int *)a];
+}
+
+// Builds the table with the "hash, displace" method: the biggest buckets
+// are placed first, each trying displacements until all of its msgids land
+// on free slots
+static unsigned char * BuildTable(uint32_t * tableSize)
+{
+	uint32_t buckets = msgCount / 4 + 1;
+	uint32_t slots = 1;
+	uint32_t size, offset;
+	uint32_t i, b;
+	int j;
+
+	while (slots < (uint32_t) msgCount)
+		slots <<= 1;
+
+	int * order = (int *) malloc(buckets * sizeof(int));
+	uint32_t * disp = (uint32_t *) calloc(buckets, sizeof(uint32_t));
+	int * slotMsg = (int *) malloc(slots * sizeof(int));
+	uint32_t * tried = (uint32_t *) malloc(slots * sizeof(uint32_t));
+	bucketSize = (int *) calloc(buckets, sizeof(int));
+
+	for (j = 0; j < msgCount; j++)
+		bucketSize[LangTabBucket(msgs[j].id, buckets)]++;
+
+	for (b = 0; b < buckets; b++)
+		order[b] = b;
+	qsort(order, buckets, sizeof(int), CompareBuckets);
+
+	for (i = 0; i < slots; i++)
+		slotMsg[i] = -1;
+
+	for (b = 0; b < buckets && bucketSize[order[b]] > 0; b++)
+	{
+		uint32_t bucket = order[b];
+		uint32_t d;
+
+		for (d = 0; d < MAX_DISP; d++)
+		{
+			int placed = 0;
+
+			for (j = 0; j < msgCount; j++)
+			{
+				if (LangTabBucket(msgs[j].id, buckets) != bucket)
+					continue;
+
+				uint32_t s = LangTabSlot(msgs[j].id, d, slots);
+				int k;
+
+				if (slotMsg[s] >= 0)
+					break;
+
+				// two msgids of this bucket on the same slot
+				for (k = 0; k < placed; k++)
+				{
+					if (tried[k] == s)
+						break;
+				}
+				if (k < placed)
+					break;
+
+				tried[placed++] = s;
+			}
+
+			if (j == msgCount)
+				break;
+		}
+
+		if (d == MAX_DISP)
+			return NULL;
+
+		disp[bucket] = d;
+
+		for (j = 0; j < msgCount; j++)
+		{
+			if (LangTabBucket(msgs[j].id, buckets) == bucket)
+				slotMsg[LangTabSlot(msgs[j].id, d, slots)] = j;
+		}
+	}
+
+	size = LANGTAB_HEADER_SIZE + buckets * 4 + slots * 8;
+	for (j = 0; j < msgCount; j++)
+		size += strlen(msgs[j].msgstr) + 1;
+
+	unsigned char * table = (unsigned char *) calloc(size, 1);
+
+	Write32(table, LANGTAB_MAGIC);
+	Write32(table + 4, msgCount);
+	Write32(table + 8, buckets);
+	Write32(table + 12, slots);
+
+	for (b = 0; b < buckets; b++)
+		Write32(table + LANGTAB_HEADER_SIZE + b * 4, disp[b]);
+
+	offset = LANGTAB_HEADER_SIZE + buckets * 4 + slots * 8;
+
+	for (i = 0; i < slots; i++)
+	{
+		unsigned char * entry = table + LANGTAB_HEADER_SIZE + buckets * 4 + i * 8;
+
+		if (slotMsg[i] < 0)
+			continue;
+
+		MSG * msg = &msgs[slotMsg[i]];
+		Write32(entry, msg->id);
+		Write32(entry + 4, offset);
+		strcpy((char *) table + offset, msg->msgstr);
+		offset += strlen(msg->msgstr) + 1;
+	}
+
+	free(order);
+	free(disp);
+	free(slotMsg);
+	free(tried);
+	free(bucketSize);
+
+	*tableSize = size;
+	return table;
+}
+
+int main(int argc, char ** argv)
+{
+	if (argc != 3)
+	{
+		fprintf(stderr, "usage: %s <in.lang> <out.langtab>\n", argv[0]);
+		return 1;
+	}
+
+	FILE * fp = fopen(argv[1], "rb");
+	if (!fp)
+	{
+		fprintf(stderr, "%s: can't open %s\n", argv[0], argv[1]);
+		return 1;
+	}
+
+	fseek(fp, 0, SEEK_END);
+	long len = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	char * file = (char *) malloc(len + 1);
+	if (fread(file, 1, len, fp) != (size_t) len)
+	{
+		fprintf(stderr, "%s: can't read %s\n", argv[0], argv[1]);
+		fclose(fp);
+		return 1;
+	}
+	fclose(fp);
+
+	ParseLanguage(file, file + len);
+
+	uint32_t size;
+	unsigned char * table = BuildTable(&size);
+
+	if (!table)
+	{
+		fprintf(stderr, "%s: no perfect hash found for %s\n", argv[0], argv[1]);
+		return 1;
+	}
+
+	fp = fopen(argv[2], "wb");
+	if (!fp || fwrite(table, 1, size, fp) != size)
+	{
+		fprintf(stderr, "%s: can't write %s\n", argv[0], argv[2]);
+		if (fp)
+			fclose(fp);
+		remove(argv[2]);
+		return 1;
+	}
+	fclose(fp);
+	return 0;
+}
@@ -31,10 +31,12 @@
 #include "gcunzip.h"
 #include "freeze.h"
 #include "sram.h"
+#include "gameprofile.h"
 
 #include "snes9x/snes9x.h"
 #include "snes9x/memmap.h"
 #include "snes9x/cheats.h"
+#include "snes9x/fxemu.h"
 
 extern "C" {
 extern char* strcasestr(const char *, const char *);
@@ -561,6 +563,7 @@ int BrowserLoadFile()
 
 	SNESROMSize = 0;
 	S9xDeleteCheats();
+	S9xDeinitCheatData();
 	Memory.LoadROM("ROM");
 
 	if (SNESROMSize == 0)
@@ -569,6 +572,12 @@ int BrowserLoadFile()
 	}
 	else
 	{
+		// per-game settings have to be in place before the first frame
+		ApplyGameProfile(Memory.ROMCRC32);
+
+		if (Settings.SuperFX)
+			S9xResetSuperFX();
+
 		// load SRAM or snapshot
 		if (GCSettings.AutoLoad == 1)
 			LoadSRAMAuto(SILENT);
@@ -18,20 +18,20 @@
 #include "font_ttf.h"
 
 // Languages
-#include "jp_lang.h"
-#include "en_lang.h"
-#include "de_lang.h"
-#include "fr_lang.h"
-#include "es_lang.h"
-#include "it_lang.h"
-#include "nl_lang.h"
-#include "zh_lang.h"
-#include "ko_lang.h"
-#include "pt_lang.h"
-#include "pt_br_lang.h"
-#include "ca_lang.h"
-#include "tr_lang.h"
-#include "sv_lang.h"
+#include "jp_langtab.h"
+#include "en_langtab.h"
+#include "de_langtab.h"
+#include "fr_langtab.h"
+#include "es_langtab.h"
+#include "it_langtab.h"
+#include "nl_langtab.h"
+#include "zh_langtab.h"
+#include "ko_langtab.h"
+#include "pt_langtab.h"
+#include "pt_br_langtab.h"
+#include "ca_langtab.h"
+#include "tr_langtab.h"
+#include "sv_langtab.h"
 
 // Sounds
 #ifdef HW_RVL
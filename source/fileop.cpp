@@ -32,6 +32,7 @@
 #include "menu.h"
 #include "filebrowser.h"
 #include "gui/gui.h"
+#include "screenshot.h"
 
 #ifdef HW_RVL
 	#include "mem2.h"
@@ -232,6 +233,8 @@ InitDeviceThread()
  ***************************************************************************/
 void UnmountAllFAT()
 {
+	WaitForScreenshots();
+
 #ifdef HW_RVL
 	fatUnmount("sd:");
 	fatUnmount("usb:");
@@ -264,6 +267,7 @@ static bool MountFAT(int device, int silent)
 
 	if(unmountRequired[device])
 	{
+		WaitForScreenshots(); // don't pull the device out from under the writes
 		unmountRequired[device] = false;
 		fatUnmount(mapping->name2);
 		disc->shutdown();
@@ -18,7 +18,10 @@
 #include "filebrowser.h"
 #include "menu.h"
 #include "video.h"
+#include "preview.h"
+#include "screenshot.h"
 #include "utils/pngu.h"
+#include "utils/lz4.h"
 
 #include "snes9x/snes9x.h"
 #include "snes9x/port.h"
@@ -26,6 +29,12 @@
 #include "snes9x/snapshot.h"
 #include "snes9x/language.h"
 
+// compressed snapshots start with this magic and the uncompressed size (big
+// endian), followed by the snapshot as one LZ4 block
+#define SNAPSHOT_LZ4_MAGIC		"#!s9xlz4"
+#define SNAPSHOT_LZ4_HEADER		12
+#define SNAPSHOT_MAX_SIZE		(8 * 1024 * 1024)
+
 bool8 S9xOpenSnapshotFile(const char *filepath, bool8 readonly, STREAM *file)
 {
 	return FALSE;
@@ -36,6 +45,84 @@ void S9xCloseSnapshotFile(STREAM s)
 
 }
 
+/****************************************************************************
+ * FreezeCompressed
+ *
+ * Writes the snapshot LZ4 compressed. Returns false if there isn't enough
+ * memory, in which case nothing has been written
+ ***************************************************************************/
+static bool
+FreezeCompressed (STREAM fp)
+{
+	uint32 size = S9xFreezeSize();
+	int bound = LZ4_COMPRESS_BOUND(size);
+	u8 * raw = (u8 *)malloc(size);
+	u8 * packed = (u8 *)malloc(SNAPSHOT_LZ4_HEADER + bound);
+	int packedSize = 0;
+
+	if(raw && packed)
+	{
+		S9xFreezeGameMem(raw, size);
+		packedSize = LZ4Compress(raw, size, packed + SNAPSHOT_LZ4_HEADER, bound);
+	}
+
+	if(packedSize > 0)
+	{
+		memcpy(packed, SNAPSHOT_LZ4_MAGIC, 8);
+		packed[8] = size >> 24;
+		packed[9] = size >> 16;
+		packed[10] = size >> 8;
+		packed[11] = size;
+		WRITE_STREAM(packed, SNAPSHOT_LZ4_HEADER + packedSize, fp);
+	}
+
+	free(raw);
+	free(packed);
+	return packedSize > 0;
+}
+
+/****************************************************************************
+ * UnfreezeSnapshot
+ *
+ * Loads a compressed snapshot, or a plain one written by older versions
+ ***************************************************************************/
+static int
+UnfreezeSnapshot (STREAM fp)
+{
+	u8 header[SNAPSHOT_LZ4_HEADER];
+	size_t fileSize = fp->size();
+
+	if(fileSize < SNAPSHOT_LZ4_HEADER ||
+		READ_STREAM(header, SNAPSHOT_LZ4_HEADER, fp) != SNAPSHOT_LZ4_HEADER ||
+		memcmp(header, SNAPSHOT_LZ4_MAGIC, 8) != 0)
+	{
+		REVERT_STREAM(fp, 0, SEEK_SET);
+		return S9xUnfreezeFromStream(fp);
+	}
+
+	uint32 size = (header[8] << 24) | (header[9] << 16) | (header[10] << 8) | header[11];
+	int packedSize = fileSize - SNAPSHOT_LZ4_HEADER;
+
+	if(size == 0 || size > SNAPSHOT_MAX_SIZE)
+		return WRONG_FORMAT;
+
+	u8 * raw = (u8 *)malloc(size);
+	u8 * packed = (u8 *)malloc(packedSize);
+	int result = WRONG_FORMAT;
+
+	if(raw && packed && READ_STREAM(packed, packedSize, fp) == (size_t)packedSize &&
+		LZ4Decompress(packed, packedSize, raw, size) == (int)size)
+	{
+		free(packed);
+		packed = NULL;
+		result = S9xUnfreezeGameMem(raw, size);
+	}
+
+	free(raw);
+	free(packed);
+	return result;
+}
+
 /****************************************************************************
  * SaveSnapshot
  ***************************************************************************/
@@ -48,15 +135,14 @@ SaveSnapshot (char * filepath, bool silent)
 	if(!FindDevice(filepath, &device))
 		return 0;
 
-	// save screenshot
-	if(gameScreenPngSize > 0)
-	{
-		char screenpath[1024];
-		strcpy(screenpath, filepath);
-		screenpath[strlen(screenpath)-4] = 0;
-		strcat(screenpath, ".png");
-		SaveFile((char *)gameScreenPng, screenpath, gameScreenPngSize, silent);
-	}
+	// save screenshot and save browser thumbnail, encoded in the background
+	char screenpath[1024], thumbpath[1024];
+	strcpy(screenpath, filepath);
+	screenpath[strlen(screenpath)-4] = 0;
+	strcpy(thumbpath, screenpath);
+	strcat(screenpath, ".png");
+	strcat(thumbpath, ".thm");
+	QueueScreenshot(screenpath, thumbpath);
 
 	STREAM fp = OPEN_STREAM(filepath, "wb");
 	
@@ -67,7 +153,8 @@ SaveSnapshot (char * filepath, bool silent)
 		return 0;
 	}
 
-	S9xFreezeToStream(fp);
+	if(!FreezeCompressed(fp))
+		S9xFreezeToStream(fp);
 	CLOSE_STREAM(fp);
 
 	if(!silent)
@@ -106,7 +193,7 @@ LoadSnapshot (char * filepath, bool silent)
 		return 0;
 	}
 
-	int	result = S9xUnfreezeFromStream(fp);
+	int	result = UnfreezeSnapshot(fp);
 	CLOSE_STREAM(fp);
 
 	if (result == SUCCESS)
@@ -148,17 +235,12 @@ int SavePreviewImg (char * filepath, bool silent)
 {
 	int device;
 
-	if(!FindDevice(filepath, &device))
+	if(!FindDevice(filepath, &device) || !ChangeInterface(device, silent))
 		return 0;
 
-	// save screenshot
-	if(gameScreenPngSize > 0)
-	{
-		char screenpath[1024];
-		strcpy(screenpath, filepath);
-		screenpath[strlen(screenpath)] = 0;
-		strcat(screenpath, ".png");
-		SaveFile((char *)gameScreenPng, screenpath, gameScreenPngSize, silent);
-	}
-	return 1;
+	// save screenshot, encoded in the background
+	char screenpath[1024];
+	strcpy(screenpath, filepath);
+	strcat(screenpath, ".png");
+	return QueueScreenshot(screenpath, NULL) ? 1 : 0;
 }
@@ -0,0 +1,381 @@
+/****************************************************************************
+ * Snes9x Nintendo Wii/Gamecube Port
+ *
+ * Tantric 2008-2023
+ *
+ * gameprofile.cpp
+ *
+ * Per-game settings profiles
+ *
+ * A profile overrides the filter, frame skip, SuperFX overclock, audio
+ * interpolation and rendering mode for one game, identified by the CRC32
+ * of its ROM. Profiles are stored in a small binary file sorted by CRC, so
+ * the profile of a game is found with a binary search when it's loaded.
+ *
+ * While a profile is in use its values are held in GCSettings, and the
+ * global values are kept aside so they are the ones saved to settings.xml.
+ ***************************************************************************/
+
+#include <gccore.h>
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "snes9xgx.h"
+#include "gameprofile.h"
+#include "fileop.h"
+
+#include "snes9x/snes9x.h"
+#include "snes9x/fxemu.h"
+
+#define PROFILE_MAGIC	0x53395050 // S9PP
+#define PROFILE_VERSION	1
+#define PROFILE_UNSET	-1 // setting isn't overridden
+
+typedef struct
+{
+	u32 magic;
+	u32 version;
+	u32 count;
+} ProfileFileHeader;
+
+typedef struct
+{
+	u32 crc;
+	s8 FilterMethod;
+	s8 FrameSkip;
+	s8 sfxOverclock;
+	s8 Interpolation;
+	s8 render;
+	u8 pad[3];
+} GameProfile;
+
+static GameProfile * profiles = NULL; // sorted by crc
+static int numProfiles = 0;
+static int maxProfiles = 0;
+static bool profilesLoaded = false;
+static bool profilesChanged = false;
+
+static u32 activeCRC = 0;
+static bool profileActive = false;
+static GameProfile globalSettings; // global values of the overridden settings
+
+/****************************************************************************
+ * FindProfile
+ *
+ * Binary search for the profile of a game. Returns its index, or -1 if there
+ * is none - pos is set to where it would have to be inserted
+ ***************************************************************************/
+static int FindProfile(u32 crc, int * pos)
+{
+	int lo = 0, hi = numProfiles;
+
+	while(lo < hi)
+	{
+		int mid = (lo + hi) >> 1;
+
+		if(profiles[mid].crc < crc)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if(pos)
+		*pos = lo;
+
+	return (lo < numProfiles && profiles[lo].crc == crc) ? lo : -1;
+}
+
+static int CompareProfiles(const void * a, const void * b)
+{
+	u32 crcA = ((const GameProfile *)a)->crc;
+	u32 crcB = ((const GameProfile *)b)->crc;
+	return crcA < crcB ? -1 : (crcA > crcB ? 1 : 0);
+}
+
+static bool ReserveProfiles(int count)
+{
+	if(count <= maxProfiles)
+		return true;
+
+	int newMax = maxProfiles ? maxProfiles * 2 : 32;
+
+	while(newMax < count)
+		newMax *= 2;
+
+	GameProfile * newProfiles = (GameProfile *)realloc(profiles, newMax * sizeof(GameProfile));
+
+	if(!newProfiles)
+		return false;
+
+	profiles = newProfiles;
+	maxProfiles = newMax;
+	return true;
+}
+
+static void GetProfilePath(char * filepath)
+{
+	snprintf(filepath, MAXPATHLEN, "%s/%s", appPath, PROFILE_FILE_NAME);
+}
+
+/****************************************************************************
+ * LoadGameProfiles
+ ***************************************************************************/
+static void LoadGameProfiles()
+{
+	char filepath[MAXPATHLEN];
+
+	if(profilesLoaded || appPath[0] == 0)
+		return;
+
+	profilesLoaded = true;
+	numProfiles = 0;
+
+	GetProfilePath(filepath);
+
+	AllocSaveBuffer();
+
+	size_t size = LoadFile(filepath, SILENT);
+	ProfileFileHeader * header = (ProfileFileHeader *)savebuffer;
+
+	if(size >= sizeof(ProfileFileHeader) &&
+		header->magic == PROFILE_MAGIC &&
+		header->version == PROFILE_VERSION &&
+		size == sizeof(ProfileFileHeader) + header->count * sizeof(GameProfile) &&
+		ReserveProfiles(header->count))
+	{
+		memcpy(profiles, savebuffer + sizeof(ProfileFileHeader), header->count * sizeof(GameProfile));
+		numProfiles = header->count;
+
+		// the file is written sorted, but don't rely on it if it was edited
+		for(int i=1; i < numProfiles; i++)
+		{
+			if(profiles[i-1].crc > profiles[i].crc)
+			{
+				qsort(profiles, numProfiles, sizeof(GameProfile), CompareProfiles);
+				break;
+			}
+		}
+	}
+
+	FreeSaveBuffer();
+}
+
+/****************************************************************************
+ * SaveGameProfiles
+ ***************************************************************************/
+static void SaveGameProfiles()
+{
+	char filepath[MAXPATHLEN];
+
+	if(!profilesChanged || appPath[0] == 0)
+		return;
+
+	GetProfilePath(filepath);
+
+	u32 size = sizeof(ProfileFileHeader) + numProfiles * sizeof(GameProfile);
+	u8 * buffer = (u8 *)memalign(32, size);
+
+	if(!buffer)
+		return;
+
+	ProfileFileHeader * header = (ProfileFileHeader *)buffer;
+	header->magic = PROFILE_MAGIC;
+	header->version = PROFILE_VERSION;
+	header->count = numProfiles;
+
+	if(numProfiles > 0)
+		memcpy(buffer + sizeof(ProfileFileHeader), profiles, numProfiles * sizeof(GameProfile));
+
+	if(SaveFile((char *)buffer, filepath, size, SILENT) > 0)
+		profilesChanged = false;
+
+	free(buffer);
+}
+
+static void ReadSettings(GameProfile * p)
+{
+	p->FilterMethod = GCSettings.FilterMethod;
+	p->FrameSkip = GCSettings.FrameSkip;
+	p->sfxOverclock = GCSettings.sfxOverclock;
+	p->Interpolation = GCSettings.Interpolation;
+	p->render = GCSettings.render;
+}
+
+static void WriteSettings(const GameProfile * p)
+{
+	if(p->FilterMethod != PROFILE_UNSET)
+		GCSettings.FilterMethod = p->FilterMethod;
+	if(p->FrameSkip != PROFILE_UNSET)
+		GCSettings.FrameSkip = p->FrameSkip;
+	if(p->sfxOverclock != PROFILE_UNSET)
+		GCSettings.sfxOverclock = p->sfxOverclock;
+	if(p->Interpolation != PROFILE_UNSET)
+		GCSettings.Interpolation = p->Interpolation;
+	if(p->render != PROFILE_UNSET)
+		GCSettings.render = p->render;
+}
+
+static void StoreSetting(s8 * profileValue, s8 * globalValue, int value)
+{
+	if(*profileValue == PROFILE_UNSET)
+	{
+		*globalValue = value;
+	}
+	else if(*profileValue != value)
+	{
+		*profileValue = value;
+		profilesChanged = true;
+	}
+}
+
+/****************************************************************************
+ * StoreActiveProfile
+ *
+ * Copies the current values of the settings into the profile of the loaded
+ * game, as they may have been changed in the menu. Settings the profile
+ * doesn't override are global settings.
+ ***************************************************************************/
+static void StoreActiveProfile()
+{
+	int i = FindProfile(activeCRC, NULL);
+
+	if(i < 0)
+		return;
+
+	GameProfile * p = &profiles[i];
+	StoreSetting(&p->FilterMethod, &globalSettings.FilterMethod, GCSettings.FilterMethod);
+	StoreSetting(&p->FrameSkip, &globalSettings.FrameSkip, GCSettings.FrameSkip);
+	StoreSetting(&p->sfxOverclock, &globalSettings.sfxOverclock, GCSettings.sfxOverclock);
+	StoreSetting(&p->Interpolation, &globalSettings.Interpolation, GCSettings.Interpolation);
+	StoreSetting(&p->render, &globalSettings.render, GCSettings.render);
+}
+
+/****************************************************************************
+ * ApplyGameProfile
+ *
+ * Called when a game is loaded, before its first frame. Puts back the global
+ * settings if the previous game had a profile, then applies the profile of
+ * the game with the given ROM CRC, if any.
+ ***************************************************************************/
+bool ApplyGameProfile(u32 crc)
+{
+	if(profileActive)
+	{
+		StoreActiveProfile();
+		WriteSettings(&globalSettings);
+		profileActive = false;
+	}
+
+	LoadGameProfiles();
+
+	int i = FindProfile(crc, NULL);
+
+	if(i >= 0)
+	{
+		ReadSettings(&globalSettings);
+		WriteSettings(&profiles[i]);
+		activeCRC = crc;
+		profileActive = true;
+	}
+
+	ApplyCoreSettings();
+	return profileActive;
+}
+
+bool GameProfileActive()
+{
+	return profileActive;
+}
+
+/****************************************************************************
+ * CreateGameProfile
+ *
+ * Creates a profile for the loaded game from the current settings. Settings
+ * changed from now on only apply to this game.
+ ***************************************************************************/
+void CreateGameProfile(u32 crc)
+{
+	int pos;
+
+	if(profileActive)
+		return;
+
+	LoadGameProfiles();
+
+	if(FindProfile(crc, &pos) < 0)
+	{
+		if(!ReserveProfiles(numProfiles + 1))
+			return;
+
+		memmove(&profiles[pos+1], &profiles[pos], (numProfiles - pos) * sizeof(GameProfile));
+		memset(&profiles[pos], 0, sizeof(GameProfile));
+		profiles[pos].crc = crc;
+		numProfiles++;
+	}
+
+	ReadSettings(&profiles[pos]);
+	ReadSettings(&globalSettings);
+	activeCRC = crc;
+	profileActive = true;
+	profilesChanged = true;
+}
+
+/****************************************************************************
+ * RemoveGameProfile
+ *
+ * Deletes the profile of the loaded game and goes back to the global settings
+ ***************************************************************************/
+void RemoveGameProfile()
+{
+	if(!profileActive)
+		return;
+
+	int i = FindProfile(activeCRC, NULL);
+
+	if(i >= 0)
+	{
+		memmove(&profiles[i], &profiles[i+1], (numProfiles - i - 1) * sizeof(GameProfile));
+		numProfiles--;
+		profilesChanged = true;
+	}
+
+	WriteSettings(&globalSettings);
+	profileActive = false;
+	ApplyCoreSettings();
+
+	// put back the global SuperFX speed. Loading a game resets the SuperFX
+	// to apply it, that would break the game that is running
+	if (Settings.SuperFX)
+		S9xSetSuperFXSpeed();
+}
+
+/****************************************************************************
+ * SuspendGameProfile / ResumeGameProfile
+ *
+ * Used around saving the preferences. Saves the profiles if they changed and
+ * puts the global values back into GCSettings until ResumeGameProfile.
+ * Returns true if ResumeGameProfile has to be called.
+ ***************************************************************************/
+bool SuspendGameProfile()
+{
+	if(profileActive)
+		StoreActiveProfile();
+
+	SaveGameProfiles();
+
+	if(!profileActive)
+		return false;
+
+	WriteSettings(&globalSettings);
+	return true;
+}
+
+void ResumeGameProfile()
+{
+	int i = FindProfile(activeCRC, NULL);
+
+	if(profileActive && i >= 0)
+		WriteSettings(&profiles[i]);
+}
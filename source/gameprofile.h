@@ -0,0 +1,25 @@
+/****************************************************************************
+ * Snes9x Nintendo Wii/Gamecube Port
+ *
+ * Tantric 2008-2023
+ *
+ * gameprofile.h
+ *
+ * Per-game settings profiles
+ ***************************************************************************/
+
+#ifndef _GAMEPROFILE_H_
+#define _GAMEPROFILE_H_
+
+#include <gccore.h>
+
+#define PROFILE_FILE_NAME	"profiles.dat"
+
+bool ApplyGameProfile(u32 crc);
+bool GameProfileActive();
+void CreateGameProfile(u32 crc);
+void RemoveGameProfile();
+bool SuspendGameProfile();
+void ResumeGameProfile();
+
+#endif
@@ -559,9 +559,16 @@ class GuiImageData
 		//!\param i Image data
 		//!\param w Max image width (0 = not set)
 		//!\param h Max image height (0 = not set)
-		GuiImageData(const u8 * i, int w=0, int h=0);
+		//!\param cache Share the decoded image with other instances built from the same data.
+		//!Only use for data that stays valid and unchanged, such as the embedded images
+		GuiImageData(const u8 * i, int w=0, int h=0, bool cache=true);
 		//!Destructor
 		~GuiImageData();
+		//!Sets the image from data that is already in RGBA8 format
+		//!\param img Image data, allocated with memalign. The GuiImageData takes ownership of it
+		//!\param w Image width
+		//!\param h Image height
+		void SetImage(u8 * img, int w, int h);
 		//!Gets a pointer to the image data
 		//!\return pointer to image data
 		u8 * GetImage();
@@ -571,10 +578,13 @@ class GuiImageData
 		//!Gets the image height
 		//!\return image height
 		int GetHeight();
+		//!Frees cached images that are no longer in use
+		static void FlushCache();
 	protected:
 		u8 * data; //!< Image data
 		int height; //!< Height of image
 		int width; //!< Width of image
+		bool cached; //!< Image data is owned by the image cache
 };
 
 //!Display, manage, and manipulate images in the GUI
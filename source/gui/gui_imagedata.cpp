@@ -10,16 +10,134 @@
 
 #include "gui.h"
 
+#define MAX_CACHED_IMAGES 128
+
+/**
+ * Decoded image shared by every GuiImageData built from the same embedded
+ * PNG. Entries stay resident after their last reference is dropped, so a
+ * window that is opened again doesn't decode its images a second time.
+ */
+typedef struct
+{
+	const u8 * src;
+	int maxw;
+	int maxh;
+	u8 * data;
+	int width;
+	int height;
+	int refs;
+} CachedImage;
+
+static CachedImage imageCache[MAX_CACHED_IMAGES];
+static int imageCacheCount = 0;
+static mutex_t imageCacheLock = LWP_MUTEX_NULL;
+
+static void LockImageCache()
+{
+	if(imageCacheLock == LWP_MUTEX_NULL)
+		LWP_MutexInit(&imageCacheLock, false);
+
+	if(imageCacheLock != LWP_MUTEX_NULL)
+		LWP_MutexLock(imageCacheLock);
+}
+
+static void UnlockImageCache()
+{
+	if(imageCacheLock != LWP_MUTEX_NULL)
+		LWP_MutexUnlock(imageCacheLock);
+}
+
+static void ReleaseCachedImage(u8 * data)
+{
+	LockImageCache();
+
+	for(int n=0; n < imageCacheCount; n++)
+	{
+		if(imageCache[n].data == data)
+		{
+			if(imageCache[n].refs > 0)
+				imageCache[n].refs--;
+			break;
+		}
+	}
+
+	UnlockImageCache();
+}
+
 /**
  * Constructor for the GuiImageData class.
  */
-GuiImageData::GuiImageData(const u8 * i, int maxw, int maxh)
+GuiImageData::GuiImageData(const u8 * i, int maxw, int maxh, bool cache)
 {
 	data = NULL;
 	width = 0;
 	height = 0;
+	cached = false;
+
+	if(!i)
+		return;
+
+	if(!cache)
+	{
+		data = DecodePNG(i, &width, &height, data, maxw, maxh);
+		return;
+	}
+
+	LockImageCache();
+
+	CachedImage * entry = NULL;
+
+	for(int n=0; n < imageCacheCount; n++)
+	{
+		if(imageCache[n].src == i && imageCache[n].maxw == maxw && imageCache[n].maxh == maxh)
+		{
+			entry = &imageCache[n];
+			break;
+		}
+	}
+
+	if(!entry)
+	{
+		// reuse a slot that was flushed, otherwise append
+		for(int n=0; n < imageCacheCount; n++)
+		{
+			if(!imageCache[n].src)
+			{
+				entry = &imageCache[n];
+				break;
+			}
+		}
+
+		if(!entry && imageCacheCount < MAX_CACHED_IMAGES)
+			entry = &imageCache[imageCacheCount++];
 
-	if(i)
+		if(entry)
+		{
+			memset(entry, 0, sizeof(CachedImage));
+			entry->data = DecodePNG(i, &entry->width, &entry->height, NULL, maxw, maxh);
+
+			if(entry->data)
+			{
+				entry->src = i;
+				entry->maxw = maxw;
+				entry->maxh = maxh;
+			}
+		}
+	}
+
+	if(entry && entry->data)
+	{
+		entry->refs++;
+		data = entry->data;
+		width = entry->width;
+		height = entry->height;
+		cached = true;
+	}
+
+	UnlockImageCache();
+
+	// cache is full - fall back to a private copy
+	if(!cached && !entry)
 		data = DecodePNG(i, &width, &height, data, maxw, maxh);
 }
 
@@ -28,13 +146,53 @@ GuiImageData::GuiImageData(const u8 * i, int maxw, int maxh)
  */
 GuiImageData::~GuiImageData()
 {
-	if(data)
+	if(cached)
+	{
+		ReleaseCachedImage(data);
+		data = NULL;
+	}
+	else if(data)
 	{
 		free(data);
 		data = NULL;
 	}
 }
 
+/**
+ * Frees all cached images that are no longer referenced by any GuiImageData.
+ */
+void GuiImageData::FlushCache()
+{
+	LockImageCache();
+
+	for(int n=0; n < imageCacheCount; n++)
+	{
+		if(imageCache[n].src && imageCache[n].refs == 0)
+		{
+			free(imageCache[n].data);
+			memset(&imageCache[n], 0, sizeof(CachedImage));
+		}
+	}
+
+	while(imageCacheCount > 0 && !imageCache[imageCacheCount-1].src)
+		imageCacheCount--;
+
+	UnlockImageCache();
+}
+
+void GuiImageData::SetImage(u8 * img, int w, int h)
+{
+	if(cached)
+		ReleaseCachedImage(data);
+	else if(data)
+		free(data);
+
+	data = img;
+	width = w;
+	height = h;
+	cached = false;
+}
+
 u8 * GuiImageData::GetImage()
 {
 	return data;
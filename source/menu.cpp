@@ -34,6 +34,9 @@
 #include "input.h"
 #include "filter.h"
 #include "filelist.h"
+#include "preview.h"
+#include "screenshot.h"
+#include "gameprofile.h"
 #include "gui/gui.h"
 #include "menu.h"
 #include "utils/gettext.h"
@@ -217,6 +220,24 @@ HaltGui()
 	}
 }
 
+/****************************************************************************
+ * CacheLanguageFonts
+ *
+ * Renders the characters of the current language into the glyph atlases of
+ * the most used font sizes, so menus don't stall rendering glyphs on the
+ * first frames they are shown. The GUI thread must be halted.
+ ***************************************************************************/
+static void CacheLanguageFonts()
+{
+	const FT_UInt sizes[] = { 20, 22, 26 };
+	wchar_t *chars = GetLanguageCharset();
+
+	for(unsigned int i=0; i < sizeof(sizes)/sizeof(sizes[0]); i++)
+		CacheFontData(chars, sizes[i]);
+
+	delete[] chars;
+}
+
 static void ResetText()
 {
 	LoadLanguage();
@@ -224,9 +245,14 @@ static void ResetText()
 	if(mainWindow)
 	{
 		HaltGui();
+		CacheLanguageFonts();
 		mainWindow->ResetText();
 		ResumeGui();
 	}
+	else
+	{
+		CacheLanguageFonts();
+	}
 }
 
 static int currentLanguage = -1;
@@ -636,6 +662,8 @@ InitGUIThreads()
 {
 	LWP_CreateThread (&guithread, UpdateGUI, NULL, NULL, 0, 70);
 	LWP_CreateThread (&progressthread, ProgressThread, NULL, NULL, 0, 40);
+	InitPreviewThread();
+	InitScreenshotThread();
 }
 
 /****************************************************************************
@@ -1214,8 +1242,9 @@ static int MenuGameSelection()
 	GuiImage preview;
 	preview.SetAlignment(ALIGN_CENTRE, ALIGN_MIDDLE);
 	preview.SetPosition(174, -8);
-	u8* imgBuffer = MEM_ALLOC(640 * 480 * 4);
+	u8* imgBuffer = MEM_ALLOC(PREVIEW_THUMB_SIZE);
 	int  previousBrowserIndex = -1;
+	int  previewStatus = PREVIEW_NONE;
 	char imagePath[MAXJOLIET + 1];
 	
 	HaltGui();
@@ -1288,6 +1317,7 @@ static int MenuGameSelection()
 					ShutoffRumble();
 					#endif
 					mainWindow->SetState(STATE_DISABLED);
+					HaltPreviewThread();
 					SavePrefs(SILENT);
 					if(BrowserLoadFile())
 						menu = MENU_EXIT;
@@ -1303,17 +1333,24 @@ static int MenuGameSelection()
 			previousBrowserIndex = browser.selIndex;
 			previousPreviewImg = GCSettings.PreviewImage;
 			snprintf(imagePath, MAXJOLIET, "%s%s/%s.png", pathPrefix[GCSettings.LoadMethod], getImageFolder(), browserList[browser.selIndex].displayname);
-			
+
+			// the image is decoded in the background - don't queue up every
+			// entry that was scrolled past
+			CancelPreviewRequests();
+			preview.SetImage(NULL, 0, 0);
+			previewStatus = PREVIEW_PENDING;
+		}
+
+		if(previewStatus == PREVIEW_PENDING)
+		{
 			int width, height;
-			if(DecodePNGFromFile(imagePath, &width, &height, imgBuffer, 640, 480))
+			previewStatus = GetPreviewImage(imagePath, PREVIEW_THUMB_WIDTH, PREVIEW_THUMB_HEIGHT, imgBuffer, &width, &height);
+
+			if(previewStatus == PREVIEW_READY)
 			{
 				preview.SetImage(imgBuffer, width, height);
 				preview.SetScale( MIN(225.0f / width, 235.0f / height) );
 			}
-			else
-			{
-				preview.SetImage(NULL, 0, 0);
-			}
 		}
 
 		if(settingsBtn.GetState() == STATE_CLICKED)
@@ -1328,6 +1365,7 @@ static int MenuGameSelection()
 	}
 
 	HaltParseThread(); // halt parsing
+	HaltPreviewThread();
 	HaltGui();
 	ResetBrowser();
 	mainWindow->Remove(&titleTxt);
@@ -1865,6 +1903,7 @@ static int MenuGame()
 				delete gameScreen;
 				gameScreen = NULL;
 				ClearScreenshot();
+				S9xDeinitCheatData();
 				if(GCSettings.AutoloadGame) {
 					ExitApp();
 				}
@@ -1950,6 +1989,62 @@ static int FindGameSaveNum(char * savefile, int device)
 		return -1;
 }
 
+/****************************************************************************
+ * UpdateSavePreviews
+ *
+ * Picks up save state previews that have finished decoding in the background.
+ * The small .thm thumbnail is tried first, falling back to the .png
+ * screenshot for states saved by older versions
+ ***************************************************************************/
+enum
+{
+	SAVEPREVIEW_DONE,
+	SAVEPREVIEW_THUMB,
+	SAVEPREVIEW_PNG
+};
+
+static void UpdateSavePreviews(SaveList * saves, u8 * previewPending)
+{
+	static u8 thumb[PREVIEW_SAVE_SIZE] ATTRIBUTE_ALIGN (32);
+	char scrfile[1024];
+	int width, height;
+
+	for(int j=0; j < saves->length; j++)
+	{
+		if(previewPending[j] == SAVEPREVIEW_DONE)
+			continue;
+
+		snprintf(scrfile, 1024, "%s%s/%s", pathPrefix[GCSettings.SaveMethod], GCSettings.SaveFolder, saves->filename[j]);
+		strcpy(&scrfile[strlen(scrfile)-4], previewPending[j] == SAVEPREVIEW_THUMB ? ".thm" : ".png");
+
+		int status = GetPreviewImage(scrfile, PREVIEW_SAVE_WIDTH, PREVIEW_SAVE_HEIGHT, thumb, &width, &height);
+
+		if(status == PREVIEW_PENDING)
+			continue;
+
+		if(status == PREVIEW_NONE && previewPending[j] == SAVEPREVIEW_THUMB)
+		{
+			previewPending[j] = SAVEPREVIEW_PNG;
+			continue;
+		}
+
+		previewPending[j] = SAVEPREVIEW_DONE;
+
+		if(status == PREVIEW_READY)
+		{
+			u8 * img = (u8 *)memalign(32, PREVIEW_SAVE_SIZE);
+
+			if(img)
+			{
+				memcpy(img, thumb, PREVIEW_SAVE_SIZE);
+				GuiImageData * previewImg = new GuiImageData(NULL);
+				previewImg->SetImage(img, width, height);
+				saves->previewImg[j] = previewImg;
+			}
+		}
+	}
+}
+
 /****************************************************************************
  * MenuGameSaves
  *
@@ -1962,9 +2057,9 @@ static int MenuGameSaves(int action)
 	int i, n, type, len, len2;
 	int j = 0;
 	SaveList saves;
+	u8 previewPending[MAX_SAVES+1];
 	char filepath[1024];
 	char deletepath[1024];
-	char scrfile[1024];
 	char tmp[MAXJOLIET+1];
 	struct stat filestat;
 	struct tm * timeinfo;
@@ -1976,6 +2071,9 @@ static int MenuGameSaves(int action)
 	if(!ChangeInterface(device, NOTSILENT))
 		return MENU_GAME;
 
+	// finish writing the screenshots of states that were just saved
+	WaitForScreenshots();
+
 	GuiText titleTxt(NULL, 26, (GXColor){255, 255, 255, 255});
 	titleTxt.SetAlignment(ALIGN_LEFT, ALIGN_TOP);
 	titleTxt.SetPosition(50,50);
@@ -2043,6 +2141,7 @@ static int MenuGameSaves(int action)
 	ResumeGui();
 
 	memset(&saves, 0, sizeof(saves));
+	memset(previewPending, 0, sizeof(previewPending));
 
 	sprintf(browser.dir, "%s%s", pathPrefix[GCSettings.SaveMethod], GCSettings.SaveFolder);
 	ParseDirectory(true, false);
@@ -2050,8 +2149,6 @@ static int MenuGameSaves(int action)
 	len = strlen(Memory.ROMFilename);
 
 	// find matching files
-	AllocSaveBuffer();
-
 	for(i=0; i < browser.numEntries; i++)
 	{
 		len2 = strlen(browserList[i].filename);
@@ -2076,14 +2173,10 @@ static int MenuGameSaves(int action)
 			saves.files[saves.type[j]][n] = 1;
 			strcpy(saves.filename[j], browserList[i].filename);
 
+			// previews are decoded in the background, see UpdateSavePreviews
 			if(saves.type[j] == FILE_SNAPSHOT)
-			{
-				sprintf(scrfile, "%s%s/%s.png", pathPrefix[GCSettings.SaveMethod], GCSettings.SaveFolder, tmp);
+				previewPending[j] = SAVEPREVIEW_THUMB;
 
-				memset(savebuffer, 0, SAVEBUFFERSIZE);
-				if(LoadFile(scrfile, SILENT))
-					saves.previewImg[j] = new GuiImageData(savebuffer, 64, 48);
-			}
 			snprintf(filepath, 1024, "%s%s/%s", pathPrefix[GCSettings.SaveMethod], GCSettings.SaveFolder, saves.filename[j]);
 			if (stat(filepath, &filestat) == 0)
 			{
@@ -2095,7 +2188,6 @@ static int MenuGameSaves(int action)
 		}
 	}
 
-	FreeSaveBuffer();
 	saves.length = j;
 
 	if((saves.length == 0 && action == 0) || (saves.length == 0 && action == 2)) 
@@ -2117,6 +2209,8 @@ static int MenuGameSaves(int action)
 	{
 		usleep(THREAD_SLEEP);
 
+		UpdateSavePreviews(&saves, previewPending);
+
 		ret = saveBrowser.GetClickedSave();
 
 		//load, save and delete save games
@@ -2124,6 +2218,8 @@ static int MenuGameSaves(int action)
 		{
 			int result = 0;
 
+			HaltPreviewThread();
+
 			if(action == 0) // load
 			{
 				MakeFilePath(filepath, saves.type[ret], saves.filename[ret]);
@@ -2157,6 +2253,12 @@ static int MenuGameSaves(int action)
 							deletepath[strlen(deletepath)-4] = 0;
 							strcat(deletepath, ".png");
 							remove(deletepath); // Delete the *.png file (Screenshot file)
+							InvalidatePreview(deletepath);
+							strncpy(deletepath, filepath, 1024);
+							deletepath[strlen(deletepath)-4] = 0;
+							strcat(deletepath, ".thm");
+							remove(deletepath); // Delete the *.thm file (Save browser thumbnail)
+							InvalidatePreview(deletepath);
 							strncpy(deletepath, filepath, 1024);
 							deletepath[strlen(deletepath)-4] = 0;
 							strcat(deletepath, ".frz");
@@ -2232,6 +2334,7 @@ static int MenuGameSaves(int action)
 		}
 	}
 
+	HaltPreviewThread();
 	HaltGui();
 
 	for(i=0; i < saves.length; i++)
@@ -3784,6 +3887,7 @@ static int MenuSettingsVideo()
 	sprintf(options.name[i++], "Show Framerate");
 	sprintf(options.name[i++], "Show Local Time");
 	sprintf(options.name[i++], "SuperFX Overclock");
+	sprintf(options.name[i++], "Game Profile");
 	options.length = i;
 	
 // GameCube previously disabled filtering entirely. We now allow a limited set (e.g. TV Mode scanlines).
@@ -3934,6 +4038,13 @@ static int MenuSettingsVideo()
 				S9xResetSuperFX();
 				S9xReset();
 				break;
+
+			case 13:
+				if(GameProfileActive())
+					RemoveGameProfile();
+				else if(SNESROMSize > 0)
+					CreateGameProfile(Memory.ROMCRC32);
+				break;
 		}
 
 		if(ret >= 0 || firstRun)
@@ -3959,6 +4070,7 @@ static int MenuSettingsVideo()
 			sprintf (options.value[10], "%s", Settings.DisplayFrameRate ? "On" : "Off");
 			sprintf (options.value[11], "%s", Settings.DisplayTime ? "On" : "Off");
 			sprintf (options.value[12], "%s", GetLookupString(sfxOverclockNames, GCSettings.sfxOverclock, NUM_SFX_OVERCLOCK_OPTIONS));
+			sprintf (options.value[13], "%s", GameProfileActive() ? "On" : "Off");
 			optionBrowser.TriggerUpdate();
 		}
 
@@ -4862,7 +4974,7 @@ MainMenu (int menu)
 
 	if(menu == MENU_GAME)
 	{
-		gameScreen = new GuiImageData(gameScreenPng);
+		gameScreen = new GuiImageData(gameScreenPng, 0, 0, false);
 		gameScreenImg = new GuiImage(gameScreen);
 		gameScreenImg->SetAlpha(192);
 		gameScreenImg->ColorStripe(30);
@@ -5032,6 +5144,11 @@ MainMenu (int menu)
 
 	ClearScreenshot();
 
+	#ifdef HW_DOL
+	// release decoded menu images to give the memory back to the game
+	GuiImageData::FlushCache();
+	#endif
+
 	// wait for keys to be depressed
 	while(MenuRequested())
 	{
@@ -14,7 +14,9 @@
 #include <dirent.h>
 #include <sys/stat.h>
 #include <ogcsys.h>
+#include <malloc.h>
 #include <mxml.h>
+#include <zlib.h>
 
 #include "snes9xgx.h"
 #include "menu.h"
@@ -23,6 +25,7 @@
 #include "filebrowser.h"
 #include "input.h"
 #include "button_mapping.h"
+#include "gameprofile.h"
 
 #include "snes9x/apu/apu.h"
 
@@ -408,6 +411,214 @@ decodePrefsData ()
 	return result;
 }
 
+/****************************************************************************
+ * Binary preferences cache
+ *
+ * A snapshot of the settings table and button maps, saved next to the XML
+ * file. It is loaded with a single read instead of parsing the XML, and is
+ * only used while the XML file still has the size and date it was written
+ * with, so the XML stays the editable copy.
+ ***************************************************************************/
+
+#define PREF_CACHE_MAGIC	0x53395843 // S9XC
+#define PREF_CACHE_VERSION	1
+
+typedef struct
+{
+	u32 magic;
+	u32 version;
+	u32 layout;		// checksum of the settings table the data was written with
+	u32 xmlSize;	// size and date of the XML file the cache matches
+	u32 xmlTime;
+	u32 dataSize;
+	u32 checksum;	// crc32 of the data following the header
+} PrefCacheHeader;
+
+static u8 * savedPrefs = NULL; // last data loaded or saved
+static u32 savedPrefsSize = 0;
+static char savedPrefsPath[MAXPATHLEN] = { 0 };
+
+static bool skipSetting(const SettingInfo& setting)
+{
+#ifndef HW_RVL
+	if (setting.skipOnPlatform) return true;
+#endif
+	return false;
+}
+
+static u32 settingSize(const SettingInfo& setting)
+{
+	return setting.type == TYPE_STRING ? setting.maxSize : 4;
+}
+
+/****************************************************************************
+ * prefsLayout
+ *
+ * Checksum of the names, types and sizes of the stored settings - changes
+ * whenever a setting is added, removed or resized
+ ***************************************************************************/
+static u32 prefsLayout()
+{
+	const int numSettings = sizeof(settingsConfig) / sizeof(settingsConfig[0]);
+	u32 crc = crc32(0L, Z_NULL, 0);
+
+	for (int i = 0; i < numSettings; i++) {
+		const SettingInfo& setting = settingsConfig[i];
+
+		if (skipSetting(setting)) continue;
+
+		u32 info[2] = { (u32)setting.type, settingSize(setting) };
+		crc = crc32(crc, (const Bytef *)setting.name, strlen(setting.name));
+		crc = crc32(crc, (const Bytef *)info, sizeof(info));
+	}
+
+	u32 mapSize = sizeof(btnmap);
+	return crc32(crc, (const Bytef *)&mapSize, sizeof(mapSize));
+}
+
+static u32 prefsDataSize()
+{
+	const int numSettings = sizeof(settingsConfig) / sizeof(settingsConfig[0]);
+	u32 size = sizeof(btnmap);
+
+	for (int i = 0; i < numSettings; i++)
+		if (!skipSetting(settingsConfig[i]))
+			size += settingSize(settingsConfig[i]);
+
+	return size;
+}
+
+/****************************************************************************
+ * preparePrefsCacheData
+ *
+ * Copies the settings and button maps into dst (prefsDataSize() bytes)
+ ***************************************************************************/
+static void preparePrefsCacheData(u8 * dst)
+{
+	const int numSettings = sizeof(settingsConfig) / sizeof(settingsConfig[0]);
+
+	for (int i = 0; i < numSettings; i++) {
+		const SettingInfo& setting = settingsConfig[i];
+
+		if (skipSetting(setting)) continue;
+
+		memcpy(dst, setting.ptr, settingSize(setting));
+		dst += settingSize(setting);
+	}
+	memcpy(dst, btnmap, sizeof(btnmap));
+}
+
+static void decodePrefsCacheData(const u8 * src)
+{
+	const int numSettings = sizeof(settingsConfig) / sizeof(settingsConfig[0]);
+
+	for (int i = 0; i < numSettings; i++) {
+		const SettingInfo& setting = settingsConfig[i];
+
+		if (skipSetting(setting)) continue;
+
+		memcpy(setting.ptr, src, settingSize(setting));
+
+		if (setting.type == TYPE_STRING)
+			((char *)setting.ptr)[setting.maxSize - 1] = 0;
+
+		src += settingSize(setting);
+	}
+	memcpy(btnmap, src, sizeof(btnmap));
+}
+
+static void rememberPrefs(const u8 * data, u32 size, const char * filepath)
+{
+	if (savedPrefs && savedPrefsSize != size)
+	{
+		free(savedPrefs);
+		savedPrefs = NULL;
+	}
+
+	if (!savedPrefs)
+		savedPrefs = (u8 *)malloc(size);
+
+	if (!savedPrefs)
+		return;
+
+	memcpy(savedPrefs, data, size);
+	savedPrefsSize = size;
+	snprintf(savedPrefsPath, MAXPATHLEN, "%s", filepath);
+}
+
+/****************************************************************************
+ * SavePrefsCache
+ *
+ * Writes the binary cache for the XML file at xmlpath, which must already
+ * be saved
+ ***************************************************************************/
+static bool SavePrefsCache(const char * xmlpath, const char * cachepath, const u8 * data, u32 size)
+{
+	struct stat xmlStat;
+
+	if (stat(xmlpath, &xmlStat) != 0)
+		return false;
+
+	u8 * buffer = (u8 *)memalign(32, sizeof(PrefCacheHeader) + size);
+
+	if (!buffer)
+		return false;
+
+	PrefCacheHeader * header = (PrefCacheHeader *)buffer;
+	header->magic = PREF_CACHE_MAGIC;
+	header->version = PREF_CACHE_VERSION;
+	header->layout = prefsLayout();
+	header->xmlSize = xmlStat.st_size;
+	header->xmlTime = xmlStat.st_mtime;
+	header->dataSize = size;
+	header->checksum = crc32(crc32(0L, Z_NULL, 0), data, size);
+	memcpy(buffer + sizeof(PrefCacheHeader), data, size);
+
+	size_t written = SaveFile((char *)buffer, (char *)cachepath, sizeof(PrefCacheHeader) + size, SILENT);
+	free(buffer);
+	return written > 0;
+}
+
+/****************************************************************************
+ * LoadPrefsCache
+ *
+ * Loads the settings from the binary cache, if it exists and still matches
+ * the XML file at xmlpath. Returns false if the XML has to be parsed.
+ ***************************************************************************/
+static bool LoadPrefsCache(const char * xmlpath, const char * cachepath)
+{
+	struct stat xmlStat;
+	u32 size = prefsDataSize();
+	u32 filesize = sizeof(PrefCacheHeader) + size;
+
+	u8 * buffer = (u8 *)memalign(32, filesize);
+
+	if (!buffer)
+		return false;
+
+	bool result = false;
+	PrefCacheHeader * header = (PrefCacheHeader *)buffer;
+	u8 * data = buffer + sizeof(PrefCacheHeader);
+
+	if (LoadFile((char *)buffer, (char *)cachepath, 0, filesize, SILENT) == filesize &&
+		stat(xmlpath, &xmlStat) == 0 &&
+		header->magic == PREF_CACHE_MAGIC &&
+		header->version == PREF_CACHE_VERSION &&
+		header->layout == prefsLayout() &&
+		header->xmlSize == (u32)xmlStat.st_size &&
+		header->xmlTime == (u32)xmlStat.st_mtime &&
+		header->dataSize == size &&
+		header->checksum == crc32(crc32(0L, Z_NULL, 0), data, size))
+	{
+		decodePrefsCacheData(data);
+		rememberPrefs(data, size, xmlpath);
+		result = true;
+	}
+
+	free(buffer);
+	return result;
+}
+
 /****************************************************************************
  * FixInvalidSettings
  *
@@ -576,6 +787,7 @@ bool
 SavePrefs (bool silent)
 {
 	char filepath[MAXPATHLEN];
+	char cachepath[MAXPATHLEN];
 	int datasize;
 	int offset = 0;
 	int device = 0;
@@ -627,12 +839,45 @@ SavePrefs (bool silent)
 
 	FixInvalidSettings();
 
-	AllocSaveBuffer ();
-	datasize = preparePrefsData ();
+	// the overrides of the loaded game's profile aren't global settings
+	bool profileSuspended = SuspendGameProfile();
+
+	u32 cachesize = prefsDataSize();
+	u8 * cachedata = (u8 *)malloc(cachesize);
+
+	if(cachedata)
+		preparePrefsCacheData(cachedata);
+
+	// nothing changed since the preferences were last loaded or saved
+	if(cachedata && savedPrefs && savedPrefsSize == cachesize &&
+		strcmp(savedPrefsPath, filepath) == 0 &&
+		memcmp(savedPrefs, cachedata, cachesize) == 0)
+	{
+		offset = 1;
+	}
+	else
+	{
+		AllocSaveBuffer ();
+		datasize = preparePrefsData ();
+
+		offset = SaveFile(filepath, datasize, silent);
+
+		FreeSaveBuffer ();
+
+		if(offset > 0 && cachedata)
+		{
+			snprintf(cachepath, MAXPATHLEN, "%s/%s", prefpath, PREF_CACHE_FILE_NAME);
+
+			if(SavePrefsCache(filepath, cachepath, cachedata, cachesize))
+				rememberPrefs(cachedata, cachesize, filepath);
+		}
+	}
 
-	offset = SaveFile(filepath, datasize, silent);
+	if(cachedata)
+		free(cachedata);
 
-	FreeSaveBuffer ();
+	if(profileSuspended)
+		ResumeGameProfile();
 
 	CancelAction();
 
@@ -654,16 +899,40 @@ LoadPrefsFromMethod (char * path)
 	bool retval = false;
 	int offset = 0;
 	char filepath[MAXPATHLEN];
+	char cachepath[MAXPATHLEN];
 	sprintf(filepath, "%s/%s", path, PREF_FILE_NAME);
+	sprintf(cachepath, "%s/%s", path, PREF_CACHE_FILE_NAME);
+
+	retval = LoadPrefsCache(filepath, cachepath);
 
-	AllocSaveBuffer ();
+	if (!retval)
+	{
+		AllocSaveBuffer ();
 
-	offset = LoadFile(filepath, SILENT);
+		offset = LoadFile(filepath, SILENT);
 
-	if (offset > 0)
-		retval = decodePrefsData ();
+		if (offset > 0)
+			retval = decodePrefsData ();
 
-	FreeSaveBuffer ();
+		FreeSaveBuffer ();
+
+		// write the cache so the XML doesn't need to be parsed next time
+		if (retval)
+		{
+			u32 cachesize = prefsDataSize();
+			u8 * cachedata = (u8 *)malloc(cachesize);
+
+			if (cachedata)
+			{
+				preparePrefsCacheData(cachedata);
+
+				if (SavePrefsCache(filepath, cachepath, cachedata, cachesize))
+					rememberPrefs(cachedata, cachesize, filepath);
+
+				free(cachedata);
+			}
+		}
+	}
 	
 	if(retval)
 	{
@@ -0,0 +1,390 @@
+/****************************************************************************
+ * Snes9x Nintendo Wii/Gamecube Port
+ *
+ * Tantric 2008-2023
+ *
+ * preview.cpp
+ *
+ * Background loading and caching of preview thumbnails
+ *
+ * Preview images (screenshots, covers, artwork and save state previews) are
+ * decoded on a low priority thread, scaled down to the size they are shown
+ * at, and kept in a small LRU cache so that scrolling back over a file
+ * doesn't decode it again.
+ ***************************************************************************/
+
+#include <gccore.h>
+#include <ogcsys.h>
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "snes9xgx.h"
+#include "preview.h"
+#include "screenshot.h"
+#include "utils/pngu.h"
+
+#ifdef HW_RVL
+	#include "mem2.h"
+
+	#define MEM_ALLOC(A) (u8*)mem2_malloc(A)
+	#define MEM_DEALLOC(A) mem2_free(A)
+	#define PREVIEW_CACHE_SIZE (4 * 1024 * 1024)
+#else
+	#define MEM_ALLOC(A) (u8*)memalign(32, A)
+	#define MEM_DEALLOC(A) free(A)
+	#define PREVIEW_CACHE_SIZE (1024 * 1024)
+#endif
+
+#define PREVIEW_CACHE_ENTRIES 48
+#define PREVIEW_STACK 32768
+#define THREAD_SLEEP 100
+
+typedef struct
+{
+	char filepath[MAXPATHLEN]; // empty if the slot is free
+	int maxwidth;
+	int maxheight;
+	int status;
+	u8 * data;
+	u32 size;
+	int width;
+	int height;
+	u32 lastUsed;
+} PreviewEntry;
+
+static PreviewEntry previewCache[PREVIEW_CACHE_ENTRIES];
+static u32 previewCacheUsed = 0;
+static u32 previewClock = 0;
+static mutex_t previewLock = LWP_MUTEX_NULL;
+
+static lwp_t previewthread = LWP_THREAD_NULL;
+static u8 previewstack[PREVIEW_STACK] ATTRIBUTE_ALIGN (32);
+
+static void FreeEntry(PreviewEntry * e)
+{
+	if(e->data)
+	{
+		MEM_DEALLOC(e->data);
+		previewCacheUsed -= e->size;
+	}
+	memset(e, 0, sizeof(PreviewEntry));
+}
+
+/****************************************************************************
+ * FindEntry / NewEntry
+ *
+ * Must be called with previewLock held
+ ***************************************************************************/
+static PreviewEntry * FindEntry(const char * filepath, int maxwidth, int maxheight)
+{
+	for(int i=0; i < PREVIEW_CACHE_ENTRIES; i++)
+	{
+		PreviewEntry * e = &previewCache[i];
+
+		if(e->filepath[0] && e->maxwidth == maxwidth && e->maxheight == maxheight &&
+			strcmp(e->filepath, filepath) == 0)
+			return e;
+	}
+	return NULL;
+}
+
+static PreviewEntry * NewEntry()
+{
+	PreviewEntry * oldest = NULL;
+
+	for(int i=0; i < PREVIEW_CACHE_ENTRIES; i++)
+	{
+		PreviewEntry * e = &previewCache[i];
+
+		if(!e->filepath[0])
+			return e;
+
+		// never evict a request that is still waiting to be decoded
+		if(e->status != PREVIEW_PENDING && (!oldest || e->lastUsed < oldest->lastUsed))
+			oldest = e;
+	}
+
+	if(oldest)
+		FreeEntry(oldest);
+	return oldest;
+}
+
+/****************************************************************************
+ * MakeRoom
+ *
+ * Evicts least recently used thumbnails until size more bytes fit in the
+ * cache. Must be called with previewLock held
+ ***************************************************************************/
+static void MakeRoom(u32 size)
+{
+	while(previewCacheUsed + size > PREVIEW_CACHE_SIZE)
+	{
+		PreviewEntry * oldest = NULL;
+
+		for(int i=0; i < PREVIEW_CACHE_ENTRIES; i++)
+		{
+			PreviewEntry * e = &previewCache[i];
+
+			if(e->data && (!oldest || e->lastUsed < oldest->lastUsed))
+				oldest = e;
+		}
+
+		if(!oldest)
+			break;
+
+		FreeEntry(oldest);
+	}
+}
+
+/****************************************************************************
+ * DecodePreviewFile
+ *
+ * Save state thumbnails written by screenshot.cpp are raw LZ4 compressed
+ * pixels, everything else is a PNG
+ ***************************************************************************/
+static u8 * DecodePreviewFile(const char * filepath, int * width, int * height, u8 * dst, int maxwidth, int maxheight)
+{
+	int len = strlen(filepath);
+
+	if(len > 4 && strcasecmp(&filepath[len-4], ".thm") == 0)
+		return DecodeThumbFromFile(filepath, width, height, dst, maxwidth, maxheight);
+
+	return DecodePNGFromFile(filepath, width, height, dst, maxwidth, maxheight, 1);
+}
+
+/****************************************************************************
+ * DecodeNextPreview
+ *
+ * Decodes the most recently requested pending preview. Returns false when
+ * there is nothing left to do
+ ***************************************************************************/
+static bool DecodeNextPreview()
+{
+	char filepath[MAXPATHLEN];
+	int maxwidth, maxheight;
+	PreviewEntry * next = NULL;
+
+	LWP_MutexLock(previewLock);
+
+	for(int i=0; i < PREVIEW_CACHE_ENTRIES; i++)
+	{
+		PreviewEntry * e = &previewCache[i];
+
+		if(e->filepath[0] && e->status == PREVIEW_PENDING && (!next || e->lastUsed > next->lastUsed))
+			next = e;
+	}
+
+	if(!next)
+	{
+		LWP_MutexUnlock(previewLock);
+		return false;
+	}
+
+	strcpy(filepath, next->filepath);
+	maxwidth = next->maxwidth;
+	maxheight = next->maxheight;
+
+	LWP_MutexUnlock(previewLock);
+
+	u32 size = PREVIEW_BUFFER_SIZE(maxwidth, maxheight);
+	u8 * data = MEM_ALLOC(size);
+	int width = 0, height = 0;
+
+	if(data && !DecodePreviewFile(filepath, &width, &height, data, maxwidth, maxheight))
+	{
+		MEM_DEALLOC(data);
+		data = NULL;
+	}
+
+	LWP_MutexLock(previewLock);
+
+	// the request may have been cancelled or evicted while we were decoding
+	PreviewEntry * e = FindEntry(filepath, maxwidth, maxheight);
+
+	if(e && e->status == PREVIEW_PENDING)
+	{
+		if(data)
+		{
+			MakeRoom(size);
+			e->data = data;
+			e->size = size;
+			e->width = width;
+			e->height = height;
+			e->status = PREVIEW_READY;
+			previewCacheUsed += size;
+			data = NULL;
+		}
+		else
+		{
+			e->status = PREVIEW_NONE;
+		}
+	}
+
+	LWP_MutexUnlock(previewLock);
+
+	if(data)
+		MEM_DEALLOC(data);
+
+	return true;
+}
+
+static void *
+previewcallback (void *arg)
+{
+	while(1)
+	{
+		while(DecodeNextPreview())
+			usleep(THREAD_SLEEP);
+		LWP_SuspendThread(previewthread);
+	}
+	return NULL;
+}
+
+/****************************************************************************
+ * InitPreviewThread
+ ***************************************************************************/
+void
+InitPreviewThread()
+{
+	LWP_MutexInit(&previewLock, false);
+	LWP_CreateThread (&previewthread, previewcallback, NULL, previewstack, PREVIEW_STACK, 40);
+}
+
+/****************************************************************************
+ * CancelPreviewRequests
+ *
+ * Drops all requests that haven't been decoded yet
+ ***************************************************************************/
+void
+CancelPreviewRequests()
+{
+	if(previewthread == LWP_THREAD_NULL)
+		return;
+
+	LWP_MutexLock(previewLock);
+
+	for(int i=0; i < PREVIEW_CACHE_ENTRIES; i++)
+		if(previewCache[i].filepath[0] && previewCache[i].status == PREVIEW_PENDING)
+			FreeEntry(&previewCache[i]);
+
+	LWP_MutexUnlock(previewLock);
+}
+
+/****************************************************************************
+ * HaltPreviewThread
+ *
+ * Drops all pending requests and waits for the thread to finish the image
+ * it is working on. Call this before other file operations.
+ ***************************************************************************/
+void
+HaltPreviewThread()
+{
+	if(previewthread == LWP_THREAD_NULL)
+		return;
+
+	CancelPreviewRequests();
+
+	while(!LWP_ThreadIsSuspended(previewthread))
+		usleep(THREAD_SLEEP);
+}
+
+/****************************************************************************
+ * GetPreviewImage
+ *
+ * Copies the thumbnail for filepath, scaled to fit maxwidth x maxheight, into
+ * dst. dst must hold PREVIEW_BUFFER_SIZE(maxwidth, maxheight) bytes - the
+ * image is padded to 4x4 tiles, so that is more than maxwidth x maxheight
+ * RGBA8 pixels when either isn't a multiple of 4.
+ * If the thumbnail isn't cached yet it is queued, and PREVIEW_PENDING is
+ * returned - call again later to pick it up.
+ ***************************************************************************/
+int
+GetPreviewImage(const char * filepath, int maxwidth, int maxheight, u8 * dst, int * width, int * height)
+{
+	if(previewthread == LWP_THREAD_NULL || !filepath[0] || strlen(filepath) >= MAXPATHLEN)
+		return PREVIEW_NONE;
+
+	LWP_MutexLock(previewLock);
+
+	PreviewEntry * e = FindEntry(filepath, maxwidth, maxheight);
+
+	if(!e)
+	{
+		e = NewEntry();
+
+		if(!e) // every slot is waiting to be decoded
+		{
+			LWP_MutexUnlock(previewLock);
+			LWP_ResumeThread(previewthread);
+			return PREVIEW_PENDING;
+		}
+
+		strcpy(e->filepath, filepath);
+		e->maxwidth = maxwidth;
+		e->maxheight = maxheight;
+		e->status = PREVIEW_PENDING;
+	}
+
+	e->lastUsed = ++previewClock;
+	int status = e->status;
+
+	if(status == PREVIEW_READY)
+	{
+		memcpy(dst, e->data, e->size);
+		*width = e->width;
+		*height = e->height;
+	}
+
+	LWP_MutexUnlock(previewLock);
+
+	// resume on every poll, in case the thread suspended itself just before
+	// this request was queued
+	if(status == PREVIEW_PENDING)
+		LWP_ResumeThread(previewthread);
+
+	return status;
+}
+
+/****************************************************************************
+ * InvalidatePreview
+ *
+ * Drops any cached thumbnail of filepath - call after the image is written
+ ***************************************************************************/
+void
+InvalidatePreview(const char * filepath)
+{
+	if(previewLock == LWP_MUTEX_NULL)
+		return;
+
+	LWP_MutexLock(previewLock);
+
+	for(int i=0; i < PREVIEW_CACHE_ENTRIES; i++)
+		if(previewCache[i].filepath[0] && strcmp(previewCache[i].filepath, filepath) == 0)
+			FreeEntry(&previewCache[i]);
+
+	LWP_MutexUnlock(previewLock);
+}
+
+/****************************************************************************
+ * ClearPreviewCache
+ *
+ * Frees all cached thumbnails
+ ***************************************************************************/
+void
+ClearPreviewCache()
+{
+	HaltPreviewThread();
+
+	if(previewLock == LWP_MUTEX_NULL)
+		return;
+
+	LWP_MutexLock(previewLock);
+
+	for(int i=0; i < PREVIEW_CACHE_ENTRIES; i++)
+		FreeEntry(&previewCache[i]);
+
+	LWP_MutexUnlock(previewLock);
+}
@@ -0,0 +1,44 @@
+/****************************************************************************
+ * Snes9x Nintendo Wii/Gamecube Port
+ *
+ * Tantric 2008-2023
+ *
+ * preview.h
+ *
+ * Background loading and caching of preview thumbnails
+ ***************************************************************************/
+
+#ifndef _PREVIEW_H_
+#define _PREVIEW_H_
+
+#include <gccore.h>
+
+// size of a decoded RGBA8 preview of at most w x h pixels, including the
+// padding to 4x4 tiles done by PNGU
+#define PREVIEW_BUFFER_SIZE(w, h)	(((((w) + 3) & ~3) * (((h) + 3) & ~3) * 4 + 31) & ~31)
+
+// size of the preview shown next to the game list
+#define PREVIEW_THUMB_WIDTH		228
+#define PREVIEW_THUMB_HEIGHT	236
+#define PREVIEW_THUMB_SIZE		PREVIEW_BUFFER_SIZE(PREVIEW_THUMB_WIDTH, PREVIEW_THUMB_HEIGHT)
+
+// size of the previews shown in the save browser
+#define PREVIEW_SAVE_WIDTH		64
+#define PREVIEW_SAVE_HEIGHT		48
+#define PREVIEW_SAVE_SIZE		PREVIEW_BUFFER_SIZE(PREVIEW_SAVE_WIDTH, PREVIEW_SAVE_HEIGHT)
+
+enum
+{
+	PREVIEW_NONE,		// image doesn't exist or failed to decode
+	PREVIEW_PENDING,	// queued or being decoded
+	PREVIEW_READY
+};
+
+void InitPreviewThread();
+void HaltPreviewThread();
+void CancelPreviewRequests();
+int GetPreviewImage(const char * filepath, int maxwidth, int maxheight, u8 * dst, int * width, int * height);
+void InvalidatePreview(const char * filepath);
+void ClearPreviewCache();
+
+#endif
@@ -0,0 +1,409 @@
+/****************************************************************************
+ * Snes9x Nintendo Wii/Gamecube Port
+ *
+ * Tantric 2008-2023
+ *
+ * screenshot.cpp
+ *
+ * Background encoding of save state screenshots and thumbnails
+ *
+ * Saving a state only copies the emulated frame. The PNG screenshot (with
+ * the fastest deflate level) and the small LZ4 compressed thumbnail shown
+ * in the save browser are encoded and written by a low priority thread.
+ * Call WaitForScreenshots() before a device is unmounted or the saves are
+ * listed, to make sure the files are complete.
+ ***************************************************************************/
+
+#include <gccore.h>
+#include <ogcsys.h>
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "snes9xgx.h"
+#include "screenshot.h"
+#include "preview.h"
+#include "utils/pngu.h"
+#include "utils/lz4.h"
+
+#include "snes9x/snes9x.h"
+#include "snes9x/memmap.h"
+#include "snes9x/gfx.h"
+#include "snes9x/ppu.h"
+
+#ifdef HW_RVL
+	#include "mem2.h"
+
+	#define MEM_ALLOC(A) (u8*)mem2_malloc(A)
+	#define MEM_DEALLOC(A) mem2_free(A)
+#else
+	#define MEM_ALLOC(A) (u8*)memalign(32, A)
+	#define MEM_DEALLOC(A) free(A)
+#endif
+
+#define SCREENSHOT_JOBS 2
+#define SCREENSHOT_STACK 32768
+
+typedef struct
+{
+	char pngpath[MAXPATHLEN];
+	char thumbpath[MAXPATHLEN]; // empty if no thumbnail is wanted
+	u16 * frame; // RGB565
+	int width;
+	int height;
+} ScreenshotJob;
+
+// jobs stay in the queue until they have been written
+static ScreenshotJob jobs[SCREENSHOT_JOBS];
+static int jobHead = 0;
+static int jobCount = 0;
+static mutex_t screenshotLock = LWP_MUTEX_NULL;
+static cond_t jobQueued = LWP_COND_NULL; // signalled when a job is added
+static cond_t jobDone = LWP_COND_NULL; // signalled when a job is written
+
+static lwp_t screenshotthread = LWP_THREAD_NULL;
+static u8 screenshotstack[SCREENSHOT_STACK] ATTRIBUTE_ALIGN (32);
+
+static inline u32 coordsRGBA8(u32 x, u32 y, u32 w)
+{
+	return ((((y >> 2) * (w >> 2) + (x >> 2)) << 5) + ((y & 3) << 2) + (x & 3)) << 1;
+}
+
+/****************************************************************************
+ * FitThumb
+ *
+ * Size of a thumbnail of a width x height frame that fits maxwidth x
+ * maxheight, the same way PNGU scales images down. Hi-res and interlaced
+ * frames are shown at half their width / height
+ ***************************************************************************/
+static void FitThumb(int width, int height, int maxwidth, int maxheight, int * thumbwidth, int * thumbheight)
+{
+	int w = width > 256 ? width / 2 : width;
+	int h = height > 256 ? height / 2 : height;
+
+	if(w > maxwidth || h > maxheight)
+	{
+		float ratio = (float)w/(float)h;
+
+		*thumbwidth = maxwidth;
+		*thumbheight = maxwidth/ratio;
+
+		if(*thumbheight > maxheight)
+		{
+			*thumbwidth = maxheight*ratio;
+			*thumbheight = maxheight;
+		}
+	}
+	else
+	{
+		*thumbwidth = w;
+		*thumbheight = h;
+	}
+}
+
+/****************************************************************************
+ * WritePNG
+ *
+ * Encodes the frame as RGB888 directly to the file
+ ***************************************************************************/
+static void WritePNG(ScreenshotJob * job)
+{
+	u32 rowbytes = (job->width * 3 + 3) & ~3; // the row padding PNGU expects
+	u8 * rgb = (u8 *)malloc(rowbytes * job->height);
+
+	if(!rgb)
+		return;
+
+	for(int y=0; y < job->height; y++)
+	{
+		const u16 * src = job->frame + y * job->width;
+		u8 * dst = rgb + y * rowbytes;
+
+		for(int x=0; x < job->width; x++)
+		{
+			u16 p = src[x];
+			u8 r = (p >> 11) & 0x1f;
+			u8 g = (p >> 5) & 0x3f;
+			u8 b = p & 0x1f;
+			dst[0] = (r << 3) | (r >> 2);
+			dst[1] = (g << 2) | (g >> 4);
+			dst[2] = (b << 3) | (b >> 2);
+			dst += 3;
+		}
+	}
+
+	IMGCTX pngContext = PNGU_SelectImageFromDevice(job->pngpath);
+
+	if(pngContext)
+	{
+		// the game is running while this is encoded, favour speed over size
+		if(PNGU_EncodeFromRGB(pngContext, job->width, job->height, rgb, 0, Z_BEST_SPEED) < 0)
+			remove(job->pngpath);
+		PNGU_ReleaseImageContext(pngContext);
+	}
+
+	free(rgb);
+	InvalidatePreview(job->pngpath);
+}
+
+/****************************************************************************
+ * WriteThumb
+ *
+ * Scales the frame down to a save browser thumbnail, and writes it LZ4
+ * compressed
+ ***************************************************************************/
+static void WriteThumb(ScreenshotJob * job)
+{
+	int width, height;
+	FitThumb(job->width, job->height, PREVIEW_SAVE_WIDTH, PREVIEW_SAVE_HEIGHT, &width, &height);
+
+	int size = width * height * 2;
+	int bound = LZ4_COMPRESS_BOUND(size);
+	u8 * raw = (u8 *)malloc(size);
+	u8 * packed = (u8 *)malloc(THUMB_HEADER + bound);
+	int packedSize = 0;
+
+	if(raw && packed)
+	{
+		int xRatio = (job->width << 16) / width + 1;
+		int yRatio = (job->height << 16) / height + 1;
+		u8 * dst = raw;
+
+		for(int y=0; y < height; y++)
+		{
+			const u16 * src = job->frame + ((y * yRatio) >> 16) * job->width;
+
+			for(int x=0; x < width; x++)
+			{
+				u16 p = src[(x * xRatio) >> 16];
+				*dst++ = p >> 8;
+				*dst++ = p;
+			}
+		}
+		packedSize = LZ4Compress(raw, size, packed + THUMB_HEADER, bound);
+	}
+
+	if(packedSize > 0)
+	{
+		memcpy(packed, THUMB_MAGIC, 8);
+		packed[8] = width >> 8;
+		packed[9] = width;
+		packed[10] = height >> 8;
+		packed[11] = height;
+
+		FILE * fp = fopen(job->thumbpath, "wb");
+
+		if(fp)
+		{
+			size_t written = fwrite(packed, 1, THUMB_HEADER + packedSize, fp);
+			fclose(fp);
+
+			if(written != (size_t)(THUMB_HEADER + packedSize))
+				remove(job->thumbpath);
+		}
+	}
+
+	free(raw);
+	free(packed);
+	InvalidatePreview(job->thumbpath);
+}
+
+/****************************************************************************
+ * screenshotcallback
+ *
+ * Writes the queued screenshots oldest first, sleeping on jobQueued while
+ * the queue is empty
+ ***************************************************************************/
+static void *
+screenshotcallback (void *arg)
+{
+	while(1)
+	{
+		LWP_MutexLock(screenshotLock);
+
+		while(jobCount == 0)
+			LWP_CondWait(jobQueued, screenshotLock);
+
+		ScreenshotJob * job = &jobs[jobHead];
+
+		LWP_MutexUnlock(screenshotLock);
+
+		if(job->thumbpath[0])
+			WriteThumb(job);
+		WritePNG(job);
+
+		MEM_DEALLOC(job->frame);
+
+		LWP_MutexLock(screenshotLock);
+		memset(job, 0, sizeof(ScreenshotJob));
+		jobHead = (jobHead + 1) % SCREENSHOT_JOBS;
+		jobCount--;
+		LWP_CondBroadcast(jobDone);
+		LWP_MutexUnlock(screenshotLock);
+	}
+	return NULL;
+}
+
+/****************************************************************************
+ * InitScreenshotThread
+ ***************************************************************************/
+void
+InitScreenshotThread()
+{
+	LWP_MutexInit(&screenshotLock, false);
+	LWP_CondInit(&jobQueued);
+	LWP_CondInit(&jobDone);
+	LWP_CreateThread (&screenshotthread, screenshotcallback, NULL, screenshotstack, SCREENSHOT_STACK, 30);
+}
+
+/****************************************************************************
+ * WaitForScreenshots
+ *
+ * Waits until every queued screenshot has been written
+ ***************************************************************************/
+void
+WaitForScreenshots()
+{
+	if(screenshotthread == LWP_THREAD_NULL)
+		return;
+
+	LWP_MutexLock(screenshotLock);
+
+	while(jobCount > 0)
+		LWP_CondWait(jobDone, screenshotLock);
+
+	LWP_MutexUnlock(screenshotLock);
+}
+
+/****************************************************************************
+ * QueueScreenshot
+ *
+ * Copies the last emulated frame, to be written as a PNG to pngpath and
+ * as a save browser thumbnail to thumbpath (if not NULL) in the background
+ ***************************************************************************/
+bool
+QueueScreenshot(const char * pngpath, const char * thumbpath)
+{
+	int width = IPPU.RenderedScreenWidth;
+	int height = IPPU.RenderedScreenHeight;
+
+	if(screenshotthread == LWP_THREAD_NULL || !GFX.Screen || width <= 0 || height <= 0 ||
+		strlen(pngpath) >= MAXPATHLEN || (thumbpath && strlen(thumbpath) >= MAXPATHLEN))
+		return false;
+
+	u16 * frame = (u16 *)MEM_ALLOC(width * height * 2);
+
+	if(!frame)
+		return false;
+
+	for(int y=0; y < height; y++)
+		memcpy(frame + y * width, (u8 *)GFX.Screen + y * GFX.Pitch, width * 2);
+
+	LWP_MutexLock(screenshotLock);
+
+	// wait for a free slot
+	while(jobCount == SCREENSHOT_JOBS)
+		LWP_CondWait(jobDone, screenshotLock);
+
+	ScreenshotJob * job = &jobs[(jobHead + jobCount) % SCREENSHOT_JOBS];
+	strcpy(job->pngpath, pngpath);
+	if(thumbpath)
+		strcpy(job->thumbpath, thumbpath);
+	job->frame = frame;
+	job->width = width;
+	job->height = height;
+	jobCount++;
+	LWP_CondSignal(jobQueued);
+	LWP_MutexUnlock(screenshotLock);
+	return true;
+}
+
+/****************************************************************************
+ * DecodeThumbFromFile
+ *
+ * Decodes a thumbnail written by WriteThumb to RGBA8 tiles, padded to 4x4
+ * like PNGU does. Thumbnails larger than maxwidth x maxheight are rejected
+ ***************************************************************************/
+u8 *
+DecodeThumbFromFile(const char * filepath, int * width, int * height, u8 * dst, int maxwidth, int maxheight)
+{
+	FILE * fp = fopen(filepath, "rb");
+
+	if(!fp)
+		return NULL;
+
+	u8 header[THUMB_HEADER];
+	fseek(fp, 0, SEEK_END);
+	long fileSize = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	if(fileSize <= THUMB_HEADER || fread(header, 1, THUMB_HEADER, fp) != THUMB_HEADER ||
+		memcmp(header, THUMB_MAGIC, 8) != 0)
+	{
+		fclose(fp);
+		return NULL;
+	}
+
+	int w = (header[8] << 8) | header[9];
+	int h = (header[10] << 8) | header[11];
+
+	if(w == 0 || h == 0 || w > maxwidth || h > maxheight)
+	{
+		fclose(fp);
+		return NULL;
+	}
+
+	int size = w * h * 2;
+	int packedSize = fileSize - THUMB_HEADER;
+	u8 * raw = (u8 *)malloc(size);
+	u8 * packed = (u8 *)malloc(packedSize);
+	bool ok = raw && packed && fread(packed, 1, packedSize, fp) == (size_t)packedSize &&
+		LZ4Decompress(packed, packedSize, raw, size) == size;
+
+	fclose(fp);
+	free(packed);
+
+	if(!ok)
+	{
+		free(raw);
+		return NULL;
+	}
+
+	int padWidth = (w + 3) & ~3;
+	int padHeight = (h + 3) & ~3;
+
+	for(int y=0; y < padHeight; y++)
+	{
+		for(int x=0; x < padWidth; x++)
+		{
+			u32 offset = coordsRGBA8(x, y, padWidth);
+
+			if(y >= h || x >= w)
+			{
+				dst[offset] = 0;
+				dst[offset+1] = 255;
+				dst[offset+32] = 255;
+				dst[offset+33] = 255;
+			}
+			else
+			{
+				const u8 * src = raw + (y * w + x) * 2;
+				u16 p = (src[0] << 8) | src[1];
+				u8 r = (p >> 11) & 0x1f;
+				u8 g = (p >> 5) & 0x3f;
+				u8 b = p & 0x1f;
+				dst[offset] = 255;
+				dst[offset+1] = (r << 3) | (r >> 2);
+				dst[offset+32] = (g << 2) | (g >> 4);
+				dst[offset+33] = (b << 3) | (b >> 2);
+			}
+		}
+	}
+
+	free(raw);
+	*width = w;
+	*height = h;
+	return dst;
+}
@@ -0,0 +1,26 @@
+/****************************************************************************
+ * Snes9x Nintendo Wii/Gamecube Port
+ *
+ * Tantric 2008-2023
+ *
+ * screenshot.h
+ *
+ * Background encoding of save state screenshots and thumbnails
+ ***************************************************************************/
+
+#ifndef _SCREENSHOT_H_
+#define _SCREENSHOT_H_
+
+#include <gccore.h>
+
+// thumbnails start with this magic and the width and height (big endian u16s),
+// followed by the RGB565 pixels (big endian) as one LZ4 block
+#define THUMB_MAGIC			"#!s9xthm"
+#define THUMB_HEADER		12
+
+void InitScreenshotThread();
+bool QueueScreenshot(const char * pngpath, const char * thumbpath);
+void WaitForScreenshots();
+u8 * DecodeThumbFromFile(const char * filepath, int * width, int * height, u8 * dst, int maxwidth, int maxheight);
+
+#endif
@@ -1,7 +1,7 @@
 #include <vector>
 #include <iostream>
 #include <fstream>
-#include <stack>
+#include <iterator>
 #include <stdio.h>
 
 #include "port.h"
@@ -40,140 +40,277 @@ static inline int bml_valid(char c)
     return (isalnum(c) || c == '-');
 }
 
-static std::string trim(std::string str)
+// Parses the name or value that follows a name, "=value", "=\"value\"" or
+// ": value". A malformed value leaves the line untouched.
+static void bml_parse_data(const char *&p, const char *end, bml_string &data)
 {
-    int start;
-    int end;
-    for (start = 0; str[start] && start != (int)str.length() && isblank(str[start]); start++) {}
-    if (start >= (int)str.length())
-        return std::string("");
-    for (end = str.length() - 1; isblankorlf(str[end]); end--) {}
-    return str.substr(start, end - start + 1);
-}
+    const char *q;
 
-static std::string trimcomments(std::string str)
-{
-    int end = str.length();
-    size_t comment = str.find("//");
-    if (comment != std::string::npos)
-        end = comment;
+    data.str = p;
+    data.len = 0;
 
-    for (int i = end - 1; i >= 0; i--)
+    if (p + 1 < end && p[0] == '=' && p[1] == '\"')
     {
-        if (!isblankorlf(str[i]))
-        {
-            end = i + 1;
-            break;
-        }
+        for (q = p + 2; q < end && *q != '\"' && !islf(*q); q++) {}
+        if (q == end || *q != '\"')
+            return;
+
+        data.str = p + 2;
+        data.len = q - (p + 2);
+        p = q + 1;
     }
+    else if (p < end && p[0] == '=')
+    {
+        for (q = p + 1; q < end && !islf(*q) && *q != '"' && *q != ' '; q++) {}
+        if (q < end && *q == '"')
+            return;
 
-    return str.substr(0, end);
-}
+        data.str = p + 1;
+        data.len = q - (p + 1);
+        p = q;
+    }
+    else if (p < end && p[0] == ':')
+    {
+        const char *last = end;
 
-static inline int bml_read_depth(std::string &data)
-{
-    size_t depth;
-    for (depth = 0; isblank(data[depth]) && depth < data.length(); depth++) {}
-    return depth == data.length() ? -1 : depth;
+        for (q = p + 1; q < end && isblank(*q); q++) {}
+        while (last > q && isblankorlf(last[-1]))
+            last--;
+
+        data.str = q;
+        data.len = last - q;
+        p = end;
+    }
 }
 
-static void bml_parse_depth(bml_node &node, std::string &line)
+static void bml_parse_name(const char *&p, const char *end, bml_string &name)
 {
-    unsigned int depth = bml_read_depth(line);
-    line.erase(0, depth);
-    node.depth = depth;
+    name.str = p;
+    while (p < end && bml_valid(*p))
+        p++;
+    name.len = p - name.str;
 }
 
-static void bml_parse_name(bml_node &node, std::string &line)
+static const char *bml_find_comment(const char *p, const char *end)
 {
-    int len;
-
-    for (len = 0; bml_valid(line[len]); len++) {};
+    while ((p = (const char *) memchr(p, '/', end - p)) && p + 1 < end)
+    {
+        if (p[1] == '/')
+            return p;
+        p++;
+    }
 
-    node.name = trim(line.substr(0, len));
-    line.erase(0, len);
+    return end;
 }
 
-static void bml_parse_data(bml_node &node, std::string &line)
+bool bml_parse_buffer(const char *buffer, size_t length, bml_visitor &visitor)
 {
-    int len;
+    const char *p = buffer;
+    const char *end = buffer + length;
+    std::vector<int> depths;
+    int skip_depth = -1;
 
-    if (line[0] == '=' && line[1] == '\"')
-    {
-        len = 2;
-        while (line[len] && line[len] != '\"' && !islf(line[len]))
-            len++;
-        if (line[len] != '\"')
-            return;
+    depths.reserve(16);
 
-        node.data = line.substr(2, len - 2);
-        line.erase(0, len + 1);
-    }
-    else if (line[0] == '=')
+    while (p < end)
     {
-        len = 1;
-        while (line[len] && !islf(line[len]) && line[len] != '"' && line[len] != ' ')
-            len++;
-        if (line[len] == '\"')
-            return;
-        node.data = line.substr(1, len - 1);
-        line.erase(0, len);
+        const char *line = p;
+        const char *eol = (const char *) memchr(p, '\n', end - p);
+
+        if (eol)
+            p = eol + 1;
+        else
+            p = eol = end;
+
+        eol = bml_find_comment(line, eol);
+        while (eol > line && isblankorlf(eol[-1]))
+            eol--;
+
+        const char *s = line;
+        while (s < eol && isblank(*s))
+            s++;
+
+        if (s == eol)
+            continue;
+
+        int depth = s - line;
+
+        if (skip_depth >= 0)
+        {
+            if (depth > skip_depth)
+                continue;
+            skip_depth = -1;
+        }
+
+        while (!depths.empty() && depth <= depths.back())
+        {
+            visitor.leave_node(depths.back());
+            depths.pop_back();
+        }
+
+        bml_string name, data;
+
+        bml_parse_name(s, eol, name);
+        bml_parse_data(s, eol, data);
+
+        bml_action action = visitor.enter_node(depth, name, data);
+        if (action == BML_STOP)
+            return false;
+
+        depths.push_back(depth);
+        if (action == BML_SKIP_CHILDREN)
+            skip_depth = depth;
+
+        // attributes, each preceded by blanks
+        while (s < eol && isblank(*s))
+        {
+            while (s < eol && isblank(*s))
+                s++;
+
+            bml_parse_name(s, eol, name);
+            if (name.len == 0)
+                break;
+
+            bml_parse_data(s, eol, data);
+            visitor.attribute(name, data);
+        }
     }
-    else if (line[0] == ':')
+
+    while (!depths.empty())
     {
-        len = 1;
-        while (line[len] && !islf(line[len]))
-            len++;
-        node.data = trim(line.substr(1, len - 1));
-        line.erase(0, len);
+        visitor.leave_node(depths.back());
+        depths.pop_back();
     }
 
-    return;
+    return true;
 }
 
-static std::string bml_read_line(std::ifstream &fd)
+static bool bml_read_file(const char *filename, long offset, bool single, std::vector<char> &buffer)
 {
-    std::string line;
+    FILE *fs = fopen(filename, "rb");
 
-    while (fd)
+    if (!fs)
+        return false;
+
+    if (offset && fseek(fs, offset, SEEK_SET))
     {
-        std::getline(fd, line);
-        line = trimcomments(line);
-        if (!line.empty())
+        fclose(fs);
+        return false;
+    }
+
+    size_t size = 0;
+    size_t chunk = single ? 0x1000 : 0x10000;
+    bool whole = false;
+
+    // the whole file is read in one go when its size is known
+    if (!single && !fseek(fs, 0, SEEK_END))
+    {
+        long end = ftell(fs);
+        if (end > offset)
         {
-            return line;
+            chunk = end - offset;
+            whole = true;
         }
+        fseek(fs, offset, SEEK_SET);
     }
 
-    return std::string("");
+    for (;;)
+    {
+        buffer.resize(size + chunk);
+
+        size_t got = fread(&buffer[size], 1, chunk, fs);
+        size_t scan = size;
+
+        size += got;
+        if (got < chunk || whole)
+            break;
+
+        // one top level node only needs reading up to the start of the next
+        if (single)
+        {
+            const char *b = &buffer[0];
+            const char *q = b + (scan > 2 ? scan - 2 : 0);
+            bool found = false;
+
+            while (!found && (q = (const char *) memchr(q, '\n', b + size - q)) && q + 2 < b + size)
+            {
+                q++;
+                found = !isblankorlf(q[0]) && !(q[0] == '/' && q[1] == '/');
+            }
+
+            if (found)
+                break;
+        }
+    }
+
+    fclose(fs);
+
+    buffer.resize(size);
+
+    return true;
 }
 
-static void bml_parse_attr(bml_node &node, std::string &line)
+bool bml_parse_file(const char *filename, bml_visitor &visitor)
 {
-    int len;
+    std::vector<char> buffer;
 
-    while (line.length() > 0)
+    if (!bml_read_file(filename, 0, false, buffer))
+        return false;
+
+    bml_parse_buffer(buffer.empty() ? "" : &buffer[0], buffer.size(), visitor);
+
+    return true;
+}
+
+// Builds a bml_node tree out of the parser events
+struct bml_tree_builder : public bml_visitor
+{
+    std::vector<bml_node *> nodes;
+    bool single;
+
+    bml_tree_builder(bml_node *root, bool single_node)
     {
-        if (!isblank(line[0]))
-            return;
+        nodes.push_back(root);
+        single = single_node;
+    }
 
-        while (isblank(line[0]))
-            line.erase(0, 1);
+    bml_action enter_node(int depth, const bml_string &name, const bml_string &data)
+    {
+        if (single && nodes.size() == 1 && !nodes[0]->child.empty())
+            return BML_STOP;
 
-        bml_node n;
-        len = 0;
-        while (bml_valid(line[len]))
-            len++;
-        if (len == 0)
-            return;
-        n.name = trim(line.substr(0, len));
-        line.erase(0, len);
-        bml_parse_data(n, line);
-        n.depth = node.depth + 1;
-        n.type = bml_node::ATTRIBUTE;
-        node.child.push_back(n);
+        bml_node *parent = nodes.back();
+
+        parent->child.push_back(bml_node());
+
+        bml_node *n = &parent->child.back();
+        n->depth = depth;
+        n->name.assign(name.str, name.len);
+        n->data.assign(data.str, data.len);
+
+        nodes.push_back(n);
+
+        return BML_DESCEND;
     }
-}
+
+    void attribute(const bml_string &name, const bml_string &data)
+    {
+        bml_node *n = nodes.back();
+
+        n->child.push_back(bml_node());
+
+        bml_node *a = &n->child.back();
+        a->depth = n->depth + 1;
+        a->type = bml_node::ATTRIBUTE;
+        a->name.assign(name.str, name.len);
+        a->data.assign(data.str, data.len);
+    }
+
+    void leave_node(int depth)
+    {
+        nodes.pop_back();
+    }
+};
 
 static int contains_space(const char *str)
 {
@@ -237,32 +374,18 @@ void bml_node::print()
     bml_print_node(*this, -1);
 }
 
-void bml_node::parse(std::ifstream &fd)
+void bml_node::parse(const char *buffer, size_t length)
 {
-    std::stack<bml_node *> nodestack;
-    nodestack.push(this);
+    bml_tree_builder builder(this, false);
 
-    while (fd)
-    {
-        bml_node newnode;
-        std::string line = bml_read_line(fd);
-        if (line.empty())
-            return;
-
-        int line_depth = bml_read_depth(line);
-        while (line_depth <= nodestack.top()->depth && nodestack.size() > 1)
-            nodestack.pop();
-
-        bml_parse_depth(newnode, line);
-        bml_parse_name(newnode, line);
-        bml_parse_data(newnode, line);
-        bml_parse_attr(newnode, line);
+    bml_parse_buffer(buffer, length, builder);
+}
 
-        nodestack.top()->child.push_back(newnode);
-        nodestack.push(&nodestack.top()->child.back());
-    }
+void bml_node::parse(std::ifstream &fd)
+{
+    std::string buffer((std::istreambuf_iterator<char>(fd)), std::istreambuf_iterator<char>());
 
-    return;
+    parse(buffer.data(), buffer.size());
 }
 
 bml_node *bml_node::find_subnode(std::string name)
@@ -280,12 +403,21 @@ bml_node *bml_node::find_subnode(std::string name)
 
 bool bml_node::parse_file(std::string filename)
 {
-    std::ifstream file(filename.c_str(), std::ios_base::binary);
+    bml_tree_builder builder(this, false);
+
+    return bml_parse_file(filename.c_str(), builder);
+}
+
+bool bml_node::parse_file(std::string filename, long offset)
+{
+    std::vector<char> buffer;
 
-    if (!file)
+    if (!bml_read_file(filename.c_str(), offset, true, buffer))
         return false;
 
-    parse(file);
+    bml_tree_builder builder(this, true);
+
+    bml_parse_buffer(buffer.empty() ? "" : &buffer[0], buffer.size(), builder);
 
     return true;
 }
@@ -3,6 +3,52 @@
 #include <vector>
 #include <string>
 #include <fstream>
+#include <string.h>
+#include <strings.h>
+
+// A slice of the buffer being parsed, not NUL terminated
+struct bml_string
+{
+    const char *str;
+    size_t len;
+
+    bool equals(const char *s) const
+    {
+        return strlen(s) == len && !memcmp(str, s, len);
+    }
+
+    bool iequals(const char *s) const
+    {
+        return strlen(s) == len && !strncasecmp(str, s, len);
+    }
+
+    std::string to_string() const
+    {
+        return std::string(str, len);
+    }
+};
+
+enum bml_action
+{
+    BML_DESCEND,        // visit the children of the node
+    BML_SKIP_CHILDREN,
+    BML_STOP
+};
+
+// Receives the nodes of a document in order. The strings point into the
+// parsed buffer and are only valid during the call.
+struct bml_visitor
+{
+    virtual ~bml_visitor() {}
+    virtual bml_action enter_node(int depth, const bml_string &name, const bml_string &data) = 0;
+    // the attributes of the node that was just entered
+    virtual void attribute(const bml_string &name, const bml_string &data) {}
+    virtual void leave_node(int depth) {}
+};
+
+// Returns false if parsing was stopped by the visitor
+bool bml_parse_buffer(const char *buffer, size_t length, bml_visitor &visitor);
+bool bml_parse_file(const char *filename, bml_visitor &visitor);
 
 struct bml_node
 {
@@ -13,7 +59,10 @@ struct bml_node
 
     bml_node();
     bool parse_file(std::string filename);
+    // parses only the top level node that starts at offset
+    bool parse_file(std::string filename, long offset);
     void parse(std::ifstream &fd);
+    void parse(const char *buffer, size_t length);
     bml_node *find_subnode(std::string name);
     void print();
 
@@ -623,6 +623,9 @@ void S9xSetBSX (uint8 byte, uint32 address)
 	}
 
 	// Flash IO
+
+	// The flash is part of ROM, so let the ROM hash finish first
+	Memory.WaitForROMHash();
 	
 	// Write to Flash
 	if (BSX.write_enable)
@@ -1358,7 +1361,11 @@ void S9xInitBSX (void)
 void S9xResetBSX (void)
 {
 	if (Settings.BSXItself)
+	{
+		// LoadROM resets before the ROM hash has finished
+		Memory.WaitForROMHash();
 		memset(Memory.ROM, 0, FLASH_SIZE);
+	}
 
 	memset(BSX.PPU, 0, sizeof(BSX.PPU));
 	memset(BSX.MMC, 0, sizeof(BSX.MMC));
@@ -27,6 +27,35 @@ static double	tanval;
 static double	c4x, c4y, c4z;
 static double	c4x2, c4y2, c4z2;
 
+// A wireframe transforms all of its vertices with the same three angles, so
+// their sines and cosines are only worked out again when an angle changes
+static bool8	c4rotvalid = FALSE;
+static int16	c4rotx, c4roty, c4rotz;
+static double	c4cosx, c4sinx, c4cosy, c4siny, c4cosz, c4sinz;
+
+static void C4UpdateRotation (void)
+{
+	if (c4rotvalid && c4rotx == C4WFX2Val && c4roty == C4WFY2Val && c4rotz == C4WFDist)
+		return;
+
+	tanval = -(double) C4WFX2Val * C4_PI * 2 / 128;
+	c4cosx = cos(tanval);
+	c4sinx = sin(tanval);
+
+	tanval = -(double) C4WFY2Val * C4_PI * 2 / 128;
+	c4cosy = cos(tanval);
+	c4siny = sin(tanval);
+
+	tanval = -(double) C4WFDist  * C4_PI * 2 / 128;
+	c4cosz = cos(tanval);
+	c4sinz = sin(tanval);
+
+	c4rotx = C4WFX2Val;
+	c4roty = C4WFY2Val;
+	c4rotz = C4WFDist;
+	c4rotvalid = TRUE;
+}
+
 
 void C4TransfWireFrame (void)
 {
@@ -34,20 +63,19 @@ void C4TransfWireFrame (void)
 	c4y = (double) C4WFYVal;
 	c4z = (double) C4WFZVal - 0x95;
 
+	C4UpdateRotation();
+
 	// Rotate X
-	tanval = -(double) C4WFX2Val * C4_PI * 2 / 128;
-	c4y2 = c4y  *  cos(tanval) - c4z  * sin(tanval);
-	c4z2 = c4y  *  sin(tanval) + c4z  * cos(tanval);
+	c4y2 = c4y  *  c4cosx - c4z  * c4sinx;
+	c4z2 = c4y  *  c4sinx + c4z  * c4cosx;
 
 	// Rotate Y
-	tanval = -(double) C4WFY2Val * C4_PI * 2 / 128;
-	c4x2 = c4x  *  cos(tanval) + c4z2 * sin(tanval);
-	c4z  = c4x  * -sin(tanval) + c4z2 * cos(tanval);
+	c4x2 = c4x  *  c4cosy + c4z2 * c4siny;
+	c4z  = c4x  * -c4siny + c4z2 * c4cosy;
 
 	// Rotate Z
-	tanval = -(double) C4WFDist  * C4_PI * 2 / 128;
-	c4x  = c4x2 *  cos(tanval) - c4y2 * sin(tanval);
-	c4y  = c4x2 *  sin(tanval) + c4y2 * cos(tanval);
+	c4x  = c4x2 *  c4cosz - c4y2 * c4sinz;
+	c4y  = c4x2 *  c4sinz + c4y2 * c4cosz;
 
 	// Scale
 	C4WFXVal = (int16) (c4x * (double) C4WFScale / (0x90 * (c4z + 0x95)) * 0x95);
@@ -60,20 +88,19 @@ void C4TransfWireFrame2 (void)
 	c4y = (double) C4WFYVal;
 	c4z = (double) C4WFZVal;
 
+	C4UpdateRotation();
+
 	// Rotate X
-	tanval = -(double) C4WFX2Val * C4_PI * 2 / 128;
-	c4y2 = c4y  *  cos(tanval) - c4z  * sin(tanval);
-	c4z2 = c4y  *  sin(tanval) + c4z  * cos(tanval);
+	c4y2 = c4y  *  c4cosx - c4z  * c4sinx;
+	c4z2 = c4y  *  c4sinx + c4z  * c4cosx;
 
 	// Rotate Y
-	tanval = -(double) C4WFY2Val * C4_PI * 2 / 128;
-	c4x2 = c4x  *  cos(tanval) + c4z2 * sin(tanval);
-	c4z  = c4x  * -sin(tanval) + c4z2 * cos(tanval);
+	c4x2 = c4x  *  c4cosy + c4z2 * c4siny;
+	c4z  = c4x  * -c4siny + c4z2 * c4cosy;
 
 	// Rotate Z
-	tanval = -(double) C4WFDist  * C4_PI * 2 / 128;
-	c4x  = c4x2 *  cos(tanval) - c4y2 * sin(tanval);
-	c4y  = c4x2 *  sin(tanval) + c4y2 * cos(tanval);
+	c4x  = c4x2 *  c4cosz - c4y2 * c4sinz;
+	c4y  = c4x2 *  c4sinz + c4y2 * c4cosz;
 
 	// Scale
 	C4WFXVal = (int16) (c4x * (double) C4WFScale / 0x100);
@@ -278,6 +278,15 @@ static void C4ConvOAM (void)
 	}
 }
 
+// Spreads the 4 bits of a pixel to bit 0 of one byte per bitplane
+static const uint32	C4PlaneBits[16] =
+{
+	0x00000000, 0x00000001, 0x00000100, 0x00000101,
+	0x00010000, 0x00010001, 0x00010100, 0x00010101,
+	0x01000000, 0x01000001, 0x01000100, 0x01000101,
+	0x01010000, 0x01010001, 0x01010100, 0x01010101
+};
+
 static void C4DoScaleRotate (int row_padding)
 {
 	int16	A, B, C, D;
@@ -366,44 +375,52 @@ static void C4DoScaleRotate (int row_padding)
 	uint32	X, Y;
 	uint8	byte;
 	int		outidx = 0;
-	uint8	bit = 0x80;
 
 	for (int y = 0; y < h; y++)
 	{
 		X = LineX;
 		Y = LineY;
 
-		for (int x = 0; x < w; x++)
+		// w is a multiple of 8, so every row is made of whole tile bytes.
+		// Each group of 8 pixels is de-bitplanified into four bytes and
+		// stored once instead of setting the output RAM bit by bit.
+		for (int x = 0; x < w; x += 8)
 		{
-			if ((X >> 12) >= w || (Y >> 12) >= h)
-				byte = 0;
-			else
-			{
-				uint32	addr = (Y >> 12) * w + (X >> 12);
-				byte = Memory.C4RAM[0x600 + (addr >> 1)];
-				if (addr & 1)
-					byte >>= 4;
-			}
+			uint32	planes = 0;
 
-			// De-bitplanify
-			if (byte & 1)
-				Memory.C4RAM[outidx]      |= bit;
-			if (byte & 2)
-				Memory.C4RAM[outidx + 1]  |= bit;
-			if (byte & 4)
-				Memory.C4RAM[outidx + 16] |= bit;
-			if (byte & 8)
-				Memory.C4RAM[outidx + 17] |= bit;
-
-			bit >>= 1;
-			if (bit == 0)
+			for (int i = 0; i < 8; i++)
 			{
-				bit = 0x80;
-				outidx += 32;
+				if ((X >> 12) >= w || (Y >> 12) >= h)
+					byte = 0;
+				else
+				{
+					uint32	addr = (Y >> 12) * w + (X >> 12);
+					uint32	src = 0x600 + (addr >> 1);
+					byte = Memory.C4RAM[src];
+
+					// Big images overlap the source with their output. A pixel
+					// that reads a byte of its own group sees the bits that
+					// were set so far, so merge in those not stored yet.
+					uint32	d = src - outidx;
+					if ((d & ~0x11) == 0)
+						byte |= (uint8) ((planes >> (((d & 1) | (d >> 3)) * 8)) << (8 - i));
+
+					if (addr & 1)
+						byte >>= 4;
+				}
+
+				// De-bitplanify
+				planes = (planes << 1) | C4PlaneBits[byte & 0x0f];
+
+				X += A; // Add 1 to output x => add an A and a C
+				Y += C;
 			}
 
-			X += A; // Add 1 to output x => add an A and a C
-			Y += C;
+			Memory.C4RAM[outidx]      |= (uint8)  planes;
+			Memory.C4RAM[outidx + 1]  |= (uint8) (planes >> 8);
+			Memory.C4RAM[outidx + 16] |= (uint8) (planes >> 16);
+			Memory.C4RAM[outidx + 17] |= (uint8) (planes >> 24);
+			outidx += 32;
 		}
 
 		outidx += 2 + row_padding;
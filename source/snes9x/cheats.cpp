@@ -4,15 +4,40 @@
    For further information, consult the LICENSE file in the root directory.
 \*****************************************************************************/
 
+#ifdef GEKKO
+#include <gccore.h>
+#include <malloc.h>
+#endif
+
 #include <ctype.h>
 #include "snes9x.h"
 #include "memmap.h"
 #include "cheats.h"
 
+#ifdef HW_RVL
+#include "../mem2.h"
+#define CHEAT_ALLOC(size)	(uint8 *) mem2_malloc(size)
+#define CHEAT_FREE(p)		mem2_free(p)
+#elif defined(GEKKO)
+#define CHEAT_ALLOC(size)	(uint8 *) memalign(32, size)
+#define CHEAT_FREE(p)		free(p)
+#else
+#define CHEAT_ALLOC(size)	(uint8 *) malloc(size)
+#define CHEAT_FREE(p)		free(p)
+#endif
+
 #define WRAM_BITS	ALL_BITS
 #define SRAM_BITS	ALL_BITS + (0x20000 >> 5)
 #define IRAM_BITS	ALL_BITS + (0x30000 >> 5)
 
+// only the first 64KB of SRAM are searched
+#define CHEAT_WRAM_SIZE		0x20000
+#define CHEAT_SRAM_SIZE		0x10000
+#define CHEAT_IRAM_SIZE		0x2000
+#define CHEAT_BITS_SIZE		(0x32000 >> 3)
+#define CHEAT_SEARCH_SIZE	(CHEAT_WRAM_SIZE + CHEAT_SRAM_SIZE + CHEAT_IRAM_SIZE + CHEAT_BITS_SIZE)
+#define CHEAT_WATCH_SIZE	0x32000
+
 #define BIT_CLEAR(a, v)	(a)[(v) >> 5] &= ~(1 << ((v) & 31))
 
 #define TEST_BIT(a, v)	((a)[(v) >> 5] & (1 << ((v) & 31)))
@@ -25,18 +50,6 @@
 	 (c) == S9X_EQUAL                 ? (a) == (b) : \
 	                                    (a) != (b))
 
-#define _S9XCHTD(s, m, o) \
-	((s) == S9X_8_BITS  ? ((uint8)   (*((m) + (o)))) : \
-	 (s) == S9X_16_BITS ? ((uint16)  (*((m) + (o)) + (*((m) + (o) + 1) << 8))) : \
-	 (s) == S9X_24_BITS ? ((uint32)  (*((m) + (o)) + (*((m) + (o) + 1) << 8) + (*((m) + (o) + 2) << 16))) : \
-	                      ((uint32)  (*((m) + (o)) + (*((m) + (o) + 1) << 8) + (*((m) + (o) + 2) << 16) + (*((m) + (o) + 3) << 24))))
-
-#define _S9XCHTDS(s, m, o) \
-	((s) == S9X_8_BITS  ?  ((int8)   (*((m) + (o)))) : \
-	 (s) == S9X_16_BITS ?  ((int16)  (*((m) + (o)) + (*((m) + (o) + 1) << 8))) : \
-	 (s) == S9X_24_BITS ? (((int32) ((*((m) + (o)) + (*((m) + (o) + 1) << 8) + (*((m) + (o) + 2) << 16)) << 8)) >> 8): \
-                           ((int32)  (*((m) + (o)) + (*((m) + (o) + 1) << 8) + (*((m) + (o) + 2) << 16) + (*((m) + (o) + 3) << 24))))
-
 static bool8 S9xAllHex (const char *, int);
 
 
@@ -145,106 +158,226 @@ const char * S9xGameGenieToRaw (const char *code, uint32 &address, uint8 &byte)
 
 void S9xStartCheatSearch (SCheatData *d)
 {
-	memmove(d->CWRAM, d->RAM, 0x20000);
-	memmove(d->CSRAM, d->SRAM, 0x80000);
-	memmove(d->CIRAM, &d->FillRAM[0x3000], 0x2000);
-	memset((char *) d->ALL_BITS, 0xff, 0x32000 >> 3);
+	if (!d->CWRAM)
+	{
+		// one block for the copies and the result bits, so it can't be half allocated
+		uint8	*block = CHEAT_ALLOC(CHEAT_SEARCH_SIZE);
+		if (!block)
+			return;
+
+		d->CWRAM    = block;
+		d->CSRAM    = d->CWRAM + CHEAT_WRAM_SIZE;
+		d->CIRAM    = d->CSRAM + CHEAT_SRAM_SIZE;
+		d->ALL_BITS = (uint32 *) (d->CIRAM + CHEAT_IRAM_SIZE);
+	}
+
+	memmove(d->CWRAM, d->RAM, CHEAT_WRAM_SIZE);
+	memmove(d->CSRAM, d->SRAM, CHEAT_SRAM_SIZE);
+	memmove(d->CIRAM, &d->FillRAM[0x3000], CHEAT_IRAM_SIZE);
+	memset((char *) d->ALL_BITS, 0xff, CHEAT_BITS_SIZE);
 }
 
-void S9xSearchForChange (SCheatData *d, S9xCheatComparisonType cmp, S9xCheatDataSize size, bool8 is_signed, bool8 update)
+void S9xEndCheatSearch (SCheatData *d)
 {
-	int	l, i;
+	if (!d->CWRAM)
+		return;
+
+	CHEAT_FREE(d->CWRAM);
+	d->CWRAM    = NULL;
+	d->CSRAM    = NULL;
+	d->CIRAM    = NULL;
+	d->ALL_BITS = NULL;
+}
 
-	switch (size)
+uint8 * S9xGetWatchRAM (void)
+{
+	if (!Cheat.CWatchRAM)
 	{
-		case S9X_8_BITS:	l = 0; break;
-		case S9X_16_BITS:	l = 1; break;
-		case S9X_24_BITS:	l = 2; break;
-		default:
-		case S9X_32_BITS:	l = 3; break;
+		Cheat.CWatchRAM = CHEAT_ALLOC(CHEAT_WATCH_SIZE);
+		if (Cheat.CWatchRAM)
+			memset(Cheat.CWatchRAM, 0, CHEAT_WATCH_SIZE);
 	}
 
+	return (Cheat.CWatchRAM);
+}
+
+void S9xFreeWatchRAM (void)
+{
+	if (!Cheat.CWatchRAM)
+		return;
+
+	CHEAT_FREE(Cheat.CWatchRAM);
+	Cheat.CWatchRAM = NULL;
+}
+
+// Releases the search and watch buffers when the game is unloaded
+void S9xDeinitCheatData (void)
+{
+	S9xEndCheatSearch(&Cheat);
+	S9xFreeWatchRAM();
+}
+
+// Returns a bit for each of the 32 bytes at a that equal the bytes at b, or
+// value if b is NULL. Compares four bytes per step.
+static uint32 CheatEqualMask (const uint8 *a, const uint8 *b, uint8 value)
+{
+	uint32	mask = 0;
+	uint32	x, y = value * 0x01010101;
+
+	for (int i = 0; i < 32; i += 4)
+	{
+		memcpy(&x, a + i, 4);
+		if (b)
+			memcpy(&y, b + i, 4);
+
+		// high bit of each byte lane is set if the bytes differ
+		x ^= y;
+		x = (((x & 0x7f7f7f7f) + 0x7f7f7f7f) | x) & 0x80808080;
+
+#ifdef LSB_FIRST
+		uint32	lanes = ((x >> 7) & 1) | ((x >> 14) & 2) | ((x >> 21) & 4) | ((x >> 28) & 8);
+#else
+		uint32	lanes = ((x >> 31) & 1) | ((x >> 22) & 2) | ((x >> 13) & 4) | ((x >> 4) & 8);
+#endif
+		mask |= (~lanes & 15) << i;
+	}
+
+	return (mask);
+}
+
+// Reads a value and maps it so that an unsigned compare gives the same order
+// as the signed or unsigned compare the user asked for
+template <int bytes>
+static inline uint32 CheatReadKey (const uint8 *m, bool8 is_signed)
+{
+	uint32	v = m[0];
+
+	if (bytes > 1)
+		v |= m[1] << 8;
+	if (bytes > 2)
+		v |= m[2] << 16;
+	if (bytes > 3)
+		v |= (uint32) m[3] << 24;
+
 	if (is_signed)
 	{
-		for (i = 0; i < 0x20000 - l; i++)
-		{
-			if (TEST_BIT(d->WRAM_BITS, i) && _S9XCHTC(cmp, _S9XCHTDS(size, d->RAM, i), _S9XCHTDS(size, d->CWRAM, i)))
-			{
-				if (update)
-					d->CWRAM[i] = d->RAM[i];
-			}
-			else
-				BIT_CLEAR(d->WRAM_BITS, i);
-		}
+		int	shift = 32 - 8 * bytes;
+		v = ((uint32) (((int32) (v << shift)) >> shift)) ^ 0x80000000;
+	}
 
-		for (i = 0; i < 0x10000 - l; i++)
-		{
-			if (TEST_BIT(d->SRAM_BITS, i) && _S9XCHTC(cmp, _S9XCHTDS(size, d->SRAM, i), _S9XCHTDS(size, d->CSRAM, i)))
-			{
-				if (update)
-					d->CSRAM[i] = d->SRAM[i];
-			}
-			else
-				BIT_CLEAR(d->SRAM_BITS, i);
-		}
+	return (v);
+}
 
-		for (i = 0; i < 0x2000 - l; i++)
-		{
-			if (TEST_BIT(d->IRAM_BITS, i) && _S9XCHTC(cmp, _S9XCHTDS(size, d->FillRAM + 0x3000, i), _S9XCHTDS(size, d->CIRAM, i)))
-			{
-				if (update)
-					d->CIRAM[i] = d->FillRAM[i + 0x3000];
-			}
-			else
-				BIT_CLEAR(d->IRAM_BITS, i);
-		}
+template <S9xCheatComparisonType cmp>
+static inline bool CheatCompare (uint32 a, uint32 b)
+{
+	switch (cmp)
+	{
+		case S9X_LESS_THAN:				return (a <  b);
+		case S9X_GREATER_THAN:			return (a >  b);
+		case S9X_LESS_THAN_OR_EQUAL:	return (a <= b);
+		case S9X_GREATER_THAN_OR_EQUAL:	return (a >= b);
+		case S9X_EQUAL:					return (a == b);
+		default:						return (a != b);
 	}
-	else
+}
+
+// Tests every candidate address in [0, n - bytes] against the old value in cmem
+// (or against value when searching by value), clearing the bits that fail.
+// Candidates are kept in 32 bit words, so words without candidates are skipped
+// entirely, and byte equality searches compare a whole word of bytes at once.
+template <S9xCheatComparisonType cmp, int bytes>
+static void CheatSearchRange (uint32 *bits, const uint8 *mem, uint8 *cmem, int n, bool8 is_signed, bool8 by_value, uint32 value, bool8 update)
+{
+	const int	last = n - bytes + 1;
+	const bool	byte_cmp = (bytes == 1 && (cmp == S9X_EQUAL || cmp == S9X_NOT_EQUAL) &&
+							(!by_value || (is_signed ? ((int32) value >= -128 && (int32) value <= 127) : value <= 0xff)));
+	const uint32	key = (by_value && is_signed) ? (value ^ 0x80000000) : value;
+
+	for (int base = 0; base < last; base += 32)
 	{
-		for (i = 0; i < 0x20000 - l; i++)
+		uint32	*word = &bits[base >> 5];
+		uint32	candidates = *word;
+
+		if (!candidates)
+			continue;
+
+		// addresses past the last full value aren't tested
+		uint32	range = (last - base >= 32) ? 0xffffffff : ((1u << (last - base)) - 1);
+		uint32	hits;
+
+		candidates &= range;
+
+		if (byte_cmp && range == 0xffffffff)
 		{
-			if (TEST_BIT(d->WRAM_BITS, i) && _S9XCHTC(cmp, _S9XCHTD(size, d->RAM, i), _S9XCHTD(size, d->CWRAM, i)))
-			{
-				if (update)
-					d->CWRAM[i] = d->RAM[i];
-			}
-			else
-				BIT_CLEAR(d->WRAM_BITS, i);
+			hits = CheatEqualMask(mem + base, by_value ? NULL : cmem + base, (uint8) value);
+			if (cmp == S9X_NOT_EQUAL)
+				hits = ~hits;
+			hits &= candidates;
 		}
-
-		for (i = 0; i < 0x10000 - l; i++)
+		else
 		{
-			if (TEST_BIT(d->SRAM_BITS, i) && _S9XCHTC(cmp, _S9XCHTD(size, d->SRAM, i), _S9XCHTD(size, d->CSRAM, i)))
+			hits = 0;
+
+			if (candidates == 0xffffffff)
 			{
-				if (update)
-					d->CSRAM[i] = d->SRAM[i];
+				for (int b = 0; b < 32; b++)
+				{
+					uint32	a = CheatReadKey<bytes>(mem + base + b, is_signed);
+
+					if (CheatCompare<cmp>(a, by_value ? key : CheatReadKey<bytes>(cmem + base + b, is_signed)))
+						hits |= 1u << b;
+				}
 			}
 			else
-				BIT_CLEAR(d->SRAM_BITS, i);
+			{
+				for (uint32 m = candidates; m; m &= m - 1)
+				{
+					int		b = __builtin_ctz(m);
+					uint32	a = CheatReadKey<bytes>(mem + base + b, is_signed);
+
+					if (CheatCompare<cmp>(a, by_value ? key : CheatReadKey<bytes>(cmem + base + b, is_signed)))
+						hits |= 1u << b;
+				}
+			}
 		}
 
-		for (i = 0; i < 0x2000 - l; i++)
+		*word = (*word & ~range) | hits;
+
+		if (update && hits)
 		{
-			if (TEST_BIT(d->IRAM_BITS, i) && _S9XCHTC(cmp, _S9XCHTD(size, d->FillRAM + 0x3000, i), _S9XCHTD(size, d->CIRAM, i)))
+			if (hits == 0xffffffff)
+				memcpy(cmem + base, mem + base, 32);
+			else
 			{
-				if (update)
-					d->CIRAM[i] = d->FillRAM[i + 0x3000];
+				for (uint32 m = hits; m; m &= m - 1)
+				{
+					int	b = __builtin_ctz(m);
+					cmem[base + b] = mem[base + b];
+				}
 			}
-			else
-				BIT_CLEAR(d->IRAM_BITS, i);
 		}
 	}
+}
 
-	for (i = 0x20000 - l; i < 0x20000; i++)
-		BIT_CLEAR(d->WRAM_BITS, i);
+#define CHEAT_SEARCH_SIZES(cmp) \
+	{ CheatSearchRange<cmp, 1>, CheatSearchRange<cmp, 2>, CheatSearchRange<cmp, 3>, CheatSearchRange<cmp, 4> }
 
-	for (i = 0x10000 - l; i < 0x10000; i++)
-		BIT_CLEAR(d->SRAM_BITS, i);
-}
+typedef void (*CheatSearchFunc) (uint32 *, const uint8 *, uint8 *, int, bool8, bool8, uint32, bool8);
 
-void S9xSearchForValue (SCheatData *d, S9xCheatComparisonType cmp, S9xCheatDataSize size, uint32 value, bool8 is_signed, bool8 update)
+static const CheatSearchFunc	CheatSearchFuncs[6][4] =
+{
+	CHEAT_SEARCH_SIZES(S9X_LESS_THAN),
+	CHEAT_SEARCH_SIZES(S9X_GREATER_THAN),
+	CHEAT_SEARCH_SIZES(S9X_LESS_THAN_OR_EQUAL),
+	CHEAT_SEARCH_SIZES(S9X_GREATER_THAN_OR_EQUAL),
+	CHEAT_SEARCH_SIZES(S9X_EQUAL),
+	CHEAT_SEARCH_SIZES(S9X_NOT_EQUAL)
+};
+
+static void CheatSearch (SCheatData *d, S9xCheatComparisonType cmp, S9xCheatDataSize size, bool8 is_signed, bool8 by_value, uint32 value, bool8 update)
 {
-	int l, i;
+	int	l;
 
 	switch (size)
 	{
@@ -255,88 +388,42 @@ void S9xSearchForValue (SCheatData *d, S9xCheatComparisonType cmp, S9xCheatDataS
 		case S9X_32_BITS:	l = 3; break;
 	}
 
-	if (is_signed)
-	{
-		for (i = 0; i < 0x20000 - l; i++)
-		{
-			if (TEST_BIT(d->WRAM_BITS, i) && _S9XCHTC(cmp, _S9XCHTDS(size, d->RAM, i), (int32) value))
-			{
-				if (update)
-					d->CWRAM[i] = d->RAM[i];
-			}
-			else
-				BIT_CLEAR(d->WRAM_BITS, i);
-		}
+	CheatSearchFunc	search = CheatSearchFuncs[(cmp >= S9X_LESS_THAN && cmp <= S9X_EQUAL) ? cmp : S9X_NOT_EQUAL][l];
 
-		for (i = 0; i < 0x10000 - l; i++)
-		{
-			if (TEST_BIT(d->SRAM_BITS, i) && _S9XCHTC(cmp, _S9XCHTDS(size, d->SRAM, i), (int32) value))
-			{
-				if (update)
-					d->CSRAM[i] = d->SRAM[i];
-			}
-			else
-				BIT_CLEAR(d->SRAM_BITS, i);
-		}
+	search(d->WRAM_BITS, d->RAM, d->CWRAM, 0x20000, is_signed, by_value, value, update);
+	search(d->SRAM_BITS, d->SRAM, d->CSRAM, 0x10000, is_signed, by_value, value, update);
+	search(d->IRAM_BITS, d->FillRAM + 0x3000, d->CIRAM, 0x2000, is_signed, by_value, value, update);
 
-		for (i = 0; i < 0x2000 - l; i++)
-		{
-			if (TEST_BIT(d->IRAM_BITS, i) && _S9XCHTC(cmp, _S9XCHTDS(size, d->FillRAM + 0x3000, i), (int32) value))
-			{
-				if (update)
-					d->CIRAM[i] = d->FillRAM[i + 0x3000];
-			}
-			else
-				BIT_CLEAR(d->IRAM_BITS, i);
-		}
-	}
-	else
-	{
-		for (i = 0; i < 0x20000 - l; i++)
-		{
-			if (TEST_BIT(d->WRAM_BITS, i) && _S9XCHTC(cmp, _S9XCHTD(size, d->RAM, i), value))
-			{
-				if (update)
-					d->CWRAM[i] = d->RAM[i];
-			}
-			else
-				BIT_CLEAR(d->WRAM_BITS, i);
-		}
+	for (int i = 0x20000 - l; i < 0x20000; i++)
+		BIT_CLEAR(d->WRAM_BITS, i);
 
-		for (i = 0; i < 0x10000 - l; i++)
-		{
-			if (TEST_BIT(d->SRAM_BITS, i) && _S9XCHTC(cmp, _S9XCHTD(size, d->SRAM, i), value))
-			{
-				if (update)
-					d->CSRAM[i] = d->SRAM[i];
-			}
-			else
-				BIT_CLEAR(d->SRAM_BITS, i);
-		}
+	for (int i = 0x10000 - l; i < 0x10000; i++)
+		BIT_CLEAR(d->SRAM_BITS, i);
+}
 
-		for (i = 0; i < 0x2000 - l; i++)
-		{
-			if (TEST_BIT(d->IRAM_BITS, i) && _S9XCHTC(cmp, _S9XCHTD(size, d->FillRAM + 0x3000, i), value))
-			{
-				if (update)
-					d->CIRAM[i] = d->FillRAM[i + 0x3000];
-			}
-			else
-				BIT_CLEAR(d->IRAM_BITS, i);
-		}
-	}
+void S9xSearchForChange (SCheatData *d, S9xCheatComparisonType cmp, S9xCheatDataSize size, bool8 is_signed, bool8 update)
+{
+	if (!d->ALL_BITS) // no search running
+		return;
 
-	for (i = 0x20000 - l; i < 0x20000; i++)
-		BIT_CLEAR(d->WRAM_BITS, i);
+	CheatSearch(d, cmp, size, is_signed, FALSE, 0, update);
+}
 
-	for (i = 0x10000 - l; i < 0x10000; i++)
-		BIT_CLEAR(d->SRAM_BITS, i);
+void S9xSearchForValue (SCheatData *d, S9xCheatComparisonType cmp, S9xCheatDataSize size, uint32 value, bool8 is_signed, bool8 update)
+{
+	if (!d->ALL_BITS) // no search running
+		return;
+
+	CheatSearch(d, cmp, size, is_signed, TRUE, value, update);
 }
 
 void S9xSearchForAddress (SCheatData *d, S9xCheatComparisonType cmp, S9xCheatDataSize size, uint32 value, bool8 update)
 {
 	int	l, i;
 
+	if (!d->ALL_BITS) // no search running
+		return;
+
 	switch (size)
 	{
 		case S9X_8_BITS:	l = 0; break;
@@ -390,6 +477,9 @@ void S9xOutputCheatSearchResults (SCheatData *d)
 {
 	int	i;
 
+	if (!d->ALL_BITS) // no search running
+		return;
+
 	for (i = 0; i < 0x20000; i++)
 	{
 		if (TEST_BIT(d->WRAM_BITS, i))
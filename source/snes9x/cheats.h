@@ -33,14 +33,14 @@ struct SCheatData
 {
 	std::vector<struct SCheatGroup> g;
 	bool8	enabled;
-	uint8	CWRAM[0x20000];
-	uint8	CSRAM[0x80000];
-	uint8	CIRAM[0x2000];
+	uint8	*CWRAM;		// search buffers, only allocated while a search is running
+	uint8	*CSRAM;
+	uint8	*CIRAM;
 	uint8	*RAM;
 	uint8	*FillRAM;
 	uint8	*SRAM;
-	uint32	ALL_BITS[0x32000 >> 5];
-	uint8	CWatchRAM[0x32000];
+	uint32	*ALL_BITS;
+	uint8	*CWatchRAM;	// allocated when a watch is first displayed
 };
 
 struct Watch
@@ -90,8 +90,12 @@ void S9xCheatsEnable (void);
 char *S9xCheatValidate (const char *cheat);
 
 void S9xInitCheatData (void);
+void S9xDeinitCheatData (void);
 void S9xInitWatchedAddress (void);
 void S9xStartCheatSearch (SCheatData *);
+void S9xEndCheatSearch (SCheatData *);
+uint8 * S9xGetWatchRAM (void);
+void S9xFreeWatchRAM (void);
 void S9xSearchForChange (SCheatData *, S9xCheatComparisonType, S9xCheatDataSize, bool8, bool8);
 void S9xSearchForValue (SCheatData *, S9xCheatComparisonType, S9xCheatDataSize, uint32, bool8, bool8);
 void S9xSearchForAddress (SCheatData *, S9xCheatComparisonType, S9xCheatDataSize, uint32, bool8);
@@ -5,6 +5,10 @@
 \*****************************************************************************/
 
 #include <ctype.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <string>
+#include <vector>
 
 #include "snes9x.h"
 #include "memmap.h"
@@ -201,6 +205,8 @@ void S9xInitWatchedAddress (void)
 {
     for (unsigned int i = 0; i < sizeof(watches) / sizeof(watches[0]); i++)
         watches[i].on = false;
+
+    S9xFreeWatchRAM();
 }
 
 void S9xInitCheatData (void)
@@ -218,6 +224,9 @@ void S9xUpdateCheatInMemory (SCheat *c)
     if (!c->enabled)
         return;
 
+    /* Cheats can patch ROM, which may still be being hashed */
+    Memory.WaitForROMHash ();
+
     byte = S9xGetByteFree (c->address);
 
     if (byte != c->byte)
@@ -263,6 +272,8 @@ void S9xDisableCheat (SCheat *c)
         return;
     }
 
+    Memory.WaitForROMHash ();
+
     /* Make sure we restore the up-to-date written byte */
     S9xUpdateCheatInMemory (c);
     c->enabled = false;
@@ -317,6 +328,8 @@ void S9xEnableCheat (SCheat *c)
     if (!Cheat.enabled)
         return;
 
+    Memory.WaitForROMHash ();
+
     byte = S9xGetByteFree(c->address);
 
     if (c->conditional)
@@ -729,16 +742,280 @@ void S9xCheatsEnable (void)
     }
 }
 
+// The cheat database is several MB, so rather than parsing all of it for every
+// ROM, an index of sha256 -> offset of the cartridge node is kept next to it
+// in <database>.idx. The index is rebuilt whenever the database's modification
+// time or size changes.
+
+#define CHEAT_INDEX_MAGIC   "S9XCIDX1"
+
+struct SCheatIndexHeader
+{
+    char   magic[8];
+    uint32 mtime;
+    uint32 size;
+    uint32 count;
+};
+
+struct SCheatIndexEntry
+{
+    uint8  sha256[32];
+    uint32 offset;
+};
+
+static bool operator < (const SCheatIndexEntry &a, const SCheatIndexEntry &b)
+{
+    int cmp = memcmp (a.sha256, b.sha256, 32);
+
+    if (cmp)
+        return cmp < 0;
+
+    return a.offset < b.offset;
+}
+
+static struct
+{
+    std::string filename;
+    uint32 mtime;
+    uint32 size;
+    std::vector<SCheatIndexEntry> entries;
+} CheatIndex;
+
+static int hexvalue (char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+// The sha256 has to be written out in full, as S9xImportCheatsFromDatabase
+// compares it as a string
+static bool8 S9xParseSHA256 (const bml_string &text, uint8 *sha256)
+{
+    if (text.len != 64)
+        return FALSE;
+
+    for (int i = 0; i < 32; i++)
+    {
+        int hi = hexvalue (text.str[i * 2]);
+        int lo = hexvalue (text.str[i * 2 + 1]);
+
+        if (hi < 0 || lo < 0)
+            return FALSE;
+
+        sha256[i] = (hi << 4) | lo;
+    }
+
+    return TRUE;
+}
+
+// Collects the offset of each top level cartridge node with its sha256, the
+// first child or attribute of that name, as find_subnode would pick it
+struct SCheatIndexBuilder : public bml_visitor
+{
+    const char *buffer;
+    std::vector<SCheatIndexEntry> &entries;
+    long cartridge;
+    bool8 found;
+    int level;
+
+    SCheatIndexBuilder (const char *b, std::vector<SCheatIndexEntry> &e) : buffer (b), entries (e)
+    {
+        cartridge = -1;
+        found = FALSE;
+        level = 0;
+    }
+
+    void sha256 (const bml_string &data)
+    {
+        SCheatIndexEntry entry;
+
+        if (cartridge < 0 || found)
+            return;
+
+        found = TRUE;
+
+        if (S9xParseSHA256 (data, entry.sha256))
+        {
+            entry.offset = cartridge;
+            entries.push_back (entry);
+        }
+    }
+
+    bml_action enter_node (int depth, const bml_string &name, const bml_string &data)
+    {
+        level++;
+
+        if (level == 1)
+        {
+            cartridge = name.iequals ("cartridge") ? name.str - buffer : -1;
+            found = FALSE;
+            return cartridge < 0 ? BML_SKIP_CHILDREN : BML_DESCEND;
+        }
+
+        // the children of a cartridge don't matter, only whether they are sha256
+        if (name.equals ("sha256"))
+            sha256 (data);
+
+        return BML_SKIP_CHILDREN;
+    }
+
+    void attribute (const bml_string &name, const bml_string &data)
+    {
+        if (level == 1 && name.equals ("sha256"))
+            sha256 (data);
+    }
+
+    void leave_node (int depth)
+    {
+        level--;
+    }
+};
+
+static bool8 S9xBuildCheatIndex (const char *filename, std::vector<SCheatIndexEntry> &entries)
+{
+    FILE *fs;
+    long size;
+
+    fs = fopen (filename, "rb");
+    if (!fs)
+        return (FALSE);
+
+    fseek (fs, 0, SEEK_END);
+    size = ftell (fs);
+    fseek (fs, 0, SEEK_SET);
+
+    std::vector<char> buffer (size > 0 ? size : 1);
+
+    if (size < 0 || (size > 0 && fread (&buffer[0], 1, size, fs) != (size_t) size))
+    {
+        fclose (fs);
+        return (FALSE);
+    }
+
+    fclose (fs);
+
+    entries.clear ();
+
+    SCheatIndexBuilder builder (&buffer[0], entries);
+    bml_parse_buffer (&buffer[0], size, builder);
+
+    std::sort (entries.begin (), entries.end ());
+
+    return (TRUE);
+}
+
+static bool8 S9xReadCheatIndex (const char *filename, uint32 mtime, uint32 size, std::vector<SCheatIndexEntry> &entries)
+{
+    SCheatIndexHeader header;
+    FILE *fs;
+    bool8 result = FALSE;
+
+    fs = fopen (filename, "rb");
+    if (!fs)
+        return (FALSE);
+
+    if (fread (&header, sizeof (header), 1, fs) == 1 &&
+        !memcmp (header.magic, CHEAT_INDEX_MAGIC, 8) &&
+        header.mtime == mtime && header.size == size)
+    {
+        entries.resize (header.count);
+
+        if (header.count == 0 || fread (&entries[0], sizeof (SCheatIndexEntry), header.count, fs) == header.count)
+            result = TRUE;
+    }
+
+    fclose (fs);
+
+    return (result);
+}
+
+static void S9xWriteCheatIndex (const char *filename, uint32 mtime, uint32 size, std::vector<SCheatIndexEntry> &entries)
+{
+    SCheatIndexHeader header;
+    FILE *fs;
+
+    fs = fopen (filename, "wb");
+    if (!fs)
+        return;
+
+    memcpy (header.magic, CHEAT_INDEX_MAGIC, 8);
+    header.mtime = mtime;
+    header.size = size;
+    header.count = entries.size ();
+
+    if (fwrite (&header, sizeof (header), 1, fs) != 1 ||
+        (header.count && fwrite (&entries[0], sizeof (SCheatIndexEntry), header.count, fs) != header.count))
+    {
+        fclose (fs);
+        remove (filename);
+        return;
+    }
+
+    fclose (fs);
+}
+
+static bool8 S9xLoadCheatIndex (const char *filename)
+{
+    struct stat st;
+
+    if (stat (filename, &st) != 0)
+        return (FALSE);
+
+    uint32 mtime = (uint32) st.st_mtime;
+    uint32 size = (uint32) st.st_size;
+
+    if (CheatIndex.filename == filename && CheatIndex.mtime == mtime && CheatIndex.size == size)
+        return (TRUE);
+
+    std::string indexname = std::string (filename) + ".idx";
+
+    CheatIndex.filename.clear ();
+
+    if (!S9xReadCheatIndex (indexname.c_str (), mtime, size, CheatIndex.entries))
+    {
+        if (!S9xBuildCheatIndex (filename, CheatIndex.entries))
+            return (FALSE);
+
+        // a read-only location still gets the in-memory index
+        S9xWriteCheatIndex (indexname.c_str (), mtime, size, CheatIndex.entries);
+    }
+
+    CheatIndex.filename = filename;
+    CheatIndex.mtime = mtime;
+    CheatIndex.size = size;
+
+    return (TRUE);
+}
+
 int S9xImportCheatsFromDatabase (const char *filename)
 {
     char sha256_txt[65];
     char hextable[] = "0123456789abcdef";
     unsigned int i;
 
-    bml_node bml;
-    if (!bml.parse_file(filename))
+    if (!S9xLoadCheatIndex (filename))
         return -1; // No file
 
+    Memory.WaitForROMHash ();
+
+    SCheatIndexEntry key;
+    memcpy (key.sha256, Memory.ROMSHA256, 32);
+    key.offset = 0;
+
+    std::vector<SCheatIndexEntry>::iterator it = std::lower_bound (CheatIndex.entries.begin (), CheatIndex.entries.end (), key);
+
+    if (it == CheatIndex.entries.end () || memcmp (it->sha256, key.sha256, 32))
+        return -2; /* No codes */
+
+    bml_node bml;
+    if (!bml.parse_file (filename, it->offset))
+        return -1;
+
     for (i = 0; i < 32; i++)
     {
         sha256_txt[i * 2]     = hextable[Memory.ROMSHA256[i] >> 4];
@@ -746,20 +1023,15 @@ int S9xImportCheatsFromDatabase (const char *filename)
     }
     sha256_txt[64] = '\0';
 
-    for (i = 0; i < bml.child.size (); i++)
+    // the node at the offset has to be the one the index was built from
+    if (bml.child.size () == 1 && !strcasecmp (bml.child[0].name.c_str(), "cartridge"))
     {
-        if (!strcasecmp (bml.child[i].name.c_str(), "cartridge"))
-        {
-            bml_node *n;
+        bml_node *n;
 
-            if ((n = bml.child[i].find_subnode ("sha256")))
-            {
-                if (!strcasecmp (n->data.c_str(), sha256_txt))
-                {
-                    S9xLoadCheatsFromBMLNode (&bml.child[i]);
-                    return 0;
-                }
-            }
+        if ((n = bml.child[0].find_subnode ("sha256")) && !strcasecmp (n->data.c_str(), sha256_txt))
+        {
+            S9xLoadCheatsFromBMLNode (&bml.child[0]);
+            return 0;
         }
     }
 
@@ -16,8 +16,29 @@ static uint8	region_map[6][6] =
 	{ 0,    0,    0,    0,    0, 0x10 }
 };
 
+// The clip windows only depend on a handful of registers, and games that
+// change them mid-frame (HDMA window shapes) tend to reuse the same values
+// line after line and frame after frame, so computed windows are cached.
+#define CLIP_CACHE_SIZE	32
+
+struct ClipCacheKey
+{
+	uint8	data[16];
+};
+
+struct ClipCacheEntry
+{
+	struct ClipCacheKey	key;
+	bool8				valid;
+	struct ClipData		Clip[2][6];
+};
+
+static struct ClipCacheEntry	ClipCache[CLIP_CACHE_SIZE];
+static int						ClipCacheCurrent = -1;	// entry that IPPU.Clip holds
+
 static inline uint8 CalcWindowMask (int, uint8, uint8);
 static inline void StoreWindowRegions (uint8, struct ClipData *, int, int16 *, uint8 *, bool8, bool8 s = FALSE);
+static void ComputeClipWindows (void);
 
 
 static inline uint8 CalcWindowMask (int i, uint8 W1, uint8 W2)
@@ -99,7 +120,62 @@ static inline void StoreWindowRegions (uint8 Mask, struct ClipData *Clip, int n_
 	Clip->Count = ct;
 }
 
+static void MakeClipCacheKey (struct ClipCacheKey *key)
+{
+	memset(key, 0, sizeof(struct ClipCacheKey));
+
+	key->data[0] = PPU.Window1Left;
+	key->data[1] = PPU.Window1Right;
+	key->data[2] = PPU.Window2Left;
+	key->data[3] = PPU.Window2Right;
+
+	for (int i = 0; i < 6; i++)
+		key->data[4 + i] = (PPU.ClipWindow1Enable[i] ? 0x01 : 0) | (PPU.ClipWindow2Enable[i] ? 0x02 : 0) |
+						   (PPU.ClipWindow1Inside[i] ? 0x04 : 0) | (PPU.ClipWindow2Inside[i] ? 0x08 : 0) |
+						   (PPU.ClipWindowOverlapLogic[i] << 4);
+
+	key->data[10] = Memory.FillRAM[0x212e] & 0x1f;
+	key->data[11] = Memory.FillRAM[0x212f] & 0x1f;
+	key->data[12] = Memory.FillRAM[0x2130] & 0xf0;
+	key->data[13] = Settings.DisableGraphicWindows ? 1 : 0;
+}
+
 void S9xComputeClipWindows (void)
+{
+	struct ClipCacheKey	key;
+
+	MakeClipCacheKey(&key);
+
+	if (ClipCacheCurrent >= 0 && memcmp(&ClipCache[ClipCacheCurrent].key, &key, sizeof(key)) == 0)
+		return;
+
+	uint32	hash = 2166136261u;
+	for (int i = 0; i < 14; i++)
+		hash = (hash ^ key.data[i]) * 16777619u;
+
+	int						index = (hash ^ (hash >> 16)) & (CLIP_CACHE_SIZE - 1);
+	struct ClipCacheEntry	*entry = &ClipCache[index];
+
+	if (entry->valid && memcmp(&entry->key, &key, sizeof(key)) == 0)
+		memcpy(IPPU.Clip, entry->Clip, sizeof(IPPU.Clip));
+	else
+	{
+		ComputeClipWindows();
+		entry->key = key;
+		entry->valid = TRUE;
+		memcpy(entry->Clip, IPPU.Clip, sizeof(IPPU.Clip));
+	}
+
+	ClipCacheCurrent = index;
+}
+
+void S9xResetClipWindowCache (void)
+{
+	// IPPU.Clip was changed behind the cache's back, the entries are still good
+	ClipCacheCurrent = -1;
+}
+
+static void ComputeClipWindows (void)
 {
 	int16	windows[6] = { 0, 256, 256, 256, 256, 256 };
 	uint8	drawing_modes[5] = { 0, 0, 0, 0, 0 };
@@ -8,7 +8,7 @@
 #include "memmap.h"
 #include "dma.h"
 #include "apu/apu.h"
-#include "sdd1emu.h"
+#include "sdd1.h"
 #include "spc7110emu.h"
 #ifdef DEBUGGER
 #include "missing.h"
@@ -25,6 +25,9 @@ static uint8	sdd1_decode_buffer[0x10000];
 static inline bool8 addCyclesInDMA (uint8);
 static inline bool8 HDMAReadLineCount (int);
 
+// Smallest run of bytes worth taking the DMA block path for
+#define DMA_BLOCK_MIN	16
+
 
 static inline bool8 addCyclesInDMA (uint8 dma_channel)
 {
@@ -49,6 +52,113 @@ static inline bool8 addCyclesInDMA (uint8 dma_channel)
 	return (TRUE);
 }
 
+// Number of bytes (at most count) that can be transferred before the next H event is due.
+// No HDMA, IRQ or line change can happen while they are transferred, so they don't need to be checked one by one.
+static inline int32 DMAEventFreeBytes (int32 count)
+{
+	if (CPU.NextEvent <= CPU.Cycles)
+		return (0);
+
+	int32	n = (CPU.NextEvent - CPU.Cycles - 1) / SLOW_ONE_CYCLE;
+
+	return (n < count ? n : count);
+}
+
+static inline void ClearTileCached (uint8 *cached, uint32 first, uint32 last, uint32 max, bool8 prev)
+{
+	memset(cached + first, FALSE, last - first + 1);
+	if (prev)
+		cached[(first - 1) & (max - 1)] = FALSE;
+}
+
+// Invalidates the cached tiles of length bytes of VRAM, the same way REGISTER_2118/2119 do for each byte
+static void InvalidateVRAMTiles (uint32 address, uint32 length)
+{
+	if (address + length > 0x10000)
+	{
+		InvalidateVRAMTiles(address, 0x10000 - address);
+		InvalidateVRAMTiles(0, address + length - 0x10000);
+		return;
+	}
+
+	uint32	last = address + length - 1;
+
+	ClearTileCached(IPPU.TileCached[TILE_2BIT],      address >> 4, last >> 4, MAX_2BIT_TILES, FALSE);
+	ClearTileCached(IPPU.TileCached[TILE_4BIT],      address >> 5, last >> 5, MAX_4BIT_TILES, FALSE);
+	ClearTileCached(IPPU.TileCached[TILE_8BIT],      address >> 6, last >> 6, MAX_8BIT_TILES, FALSE);
+	ClearTileCached(IPPU.TileCached[TILE_2BIT_EVEN], address >> 4, last >> 4, MAX_2BIT_TILES, TRUE);
+	ClearTileCached(IPPU.TileCached[TILE_2BIT_ODD],  address >> 4, last >> 4, MAX_2BIT_TILES, TRUE);
+	ClearTileCached(IPPU.TileCached[TILE_4BIT_EVEN], address >> 5, last >> 5, MAX_4BIT_TILES, TRUE);
+	ClearTileCached(IPPU.TileCached[TILE_4BIT_ODD],  address >> 5, last >> 5, MAX_4BIT_TILES, TRUE);
+}
+
+// Transfers the start of a fast path DMA chunk in one go, for the common VRAM, OAM and CGRAM uploads.
+// Returns the number of bytes transferred; the caller updates the counters and adds the cycles.
+static int32 DMABlockTransfer (SDMA *d, uint8 *base, uint16 p, int32 inc, int32 count, int32 b)
+{
+	int32	block = DMAEventFreeBytes(count);
+
+	if (block < DMA_BLOCK_MIN)
+		return (0);
+
+	if (d->TransferMode == 1 || d->TransferMode == 5)
+	{
+		// VMDATAL/VMDATAH word writes, incrementing by one word after the high byte
+		if (d->BAddress != 0x18 || b != 0 || inc != 1 ||
+			PPU.VMA.FullGraphicCount || !PPU.VMA.High || PPU.VMA.Increment != 1)
+			return (0);
+
+		if (Settings.BlockInvalidVRAMAccess && !PPU.ForcedBlanking && CPU.V_Counter < PPU.ScreenHeight + FIRST_VISIBLE_LINE)
+			return (0);
+
+		block &= ~1;
+
+		uint32	address = (PPU.VMA.Address << 1) & 0xffff;
+		uint32	first = block;
+
+		if (address + first > 0x10000)
+			first = 0x10000 - address;
+
+		// Games often upload the same tiles every frame, leave the tile cache
+		// and the screen alone when nothing actually changes
+		if (memcmp(Memory.VRAM + address, base + p, first) ||
+			(first < (uint32) block && memcmp(Memory.VRAM, base + p + first, block - first)))
+		{
+			memcpy(Memory.VRAM + address, base + p, first);
+			if (first < (uint32) block)
+				memcpy(Memory.VRAM, base + p + first, block - first);
+
+			InvalidateVRAMTiles(address, block);
+			IPPU.ScreenGeneration++;
+		}
+
+		PPU.VMA.Address += block >> 1;
+		OpenBus = *(base + p + block - 1);
+
+		return (block);
+	}
+
+	if (d->TransferMode == 0 || d->TransferMode == 2 || d->TransferMode == 6)
+	{
+		uint16	q = p;
+
+		switch (d->BAddress)
+		{
+			case 0x04: // OAMDATA
+				for (int32 i = 0; i < block; i++, q += inc)
+					REGISTER_2104(*(base + q));
+				return (block);
+
+			case 0x22: // CGDATA
+				for (int32 i = 0; i < block; i++, q += inc)
+					REGISTER_2122(*(base + q));
+				return (block);
+		}
+	}
+
+	return (0);
+}
+
 bool8 S9xDoDMA (uint8 Channel)
 {
 	CPU.InDMA = TRUE;
@@ -141,7 +251,7 @@ bool8 S9xDoDMA (uint8 Channel)
 			if (in_ptr)
 			{
 				in_ptr += d->AAddress;
-				SDD1_decompress(sdd1_decode_buffer, in_ptr, d->TransferBytes);
+				S9xSDD1Decompress(sdd1_decode_buffer, in_ptr, d->TransferBytes);
 			}
 		#ifdef DEBUGGER
 			else
@@ -402,6 +512,27 @@ bool8 S9xDoDMA (uint8 Channel)
 
 			CPU.InWRAMDMAorHDMA = inWRAM_DMA;
 
+			if (base)
+			{
+				// DMA BLOCK PATH
+				int32	done = DMABlockTransfer(d, base, p, inc, count, b);
+
+				if (done)
+				{
+					count -= done;
+					d->TransferBytes -= done;
+					d->AAddress += done * inc;
+					p += done * inc;
+					ADD_CYCLES(done * SLOW_ONE_CYCLE);
+					CPU.HDMARanInDMA = 0;
+				}
+			}
+
+			if (count <= 0)
+			{
+				// the whole chunk was done by the block path
+			}
+			else
 			if (!base)
 			{
 				// DMA SLOW PATH
@@ -1128,13 +1259,28 @@ bool8 S9xDoDMA (uint8 Channel)
 	return (TRUE);
 }
 
+// Returns a direct pointer to the len bytes of an HDMA table at Address, if they are in plain ROM or RAM
+// within one memory block. Lets a table entry be read with one map lookup instead of a bus read per byte,
+// with the data of a direct table following right after it.
+static inline uint8 * HDMATablePointer (uint32 Address, int len)
+{
+	uint8	*GetAddress = Memory.Map[(Address & 0xffffff) >> MEMMAP_SHIFT];
+
+	if (GetAddress < (uint8 *) CMemory::MAP_LAST || (Address & MEMMAP_MASK) + len > MEMMAP_BLOCK_SIZE)
+		return (NULL);
+
+	return (GetAddress + (Address & 0xffff));
+}
+
 static inline bool8 HDMAReadLineCount (int d)
 {
 	// CPU.InDMA is set, so S9xGetXXX() / S9xSetXXX() incur no charges.
 
+	uint32	Addr = (DMA[d].ABank << 16) + DMA[d].Address;
+	uint8	*Table = HDMATablePointer(Addr, DMA[d].HDMAIndirectAddressing ? 3 : 2);
 	uint8	line;
 
-	line = S9xGetByte((DMA[d].ABank << 16) + DMA[d].Address);
+	line = Table ? *Table : S9xGetByte(Addr);
 	ADD_CYCLES(SLOW_ONE_CYCLE);
 
 	if (!line)
@@ -1179,12 +1325,12 @@ static inline bool8 HDMAReadLineCount (int d)
 	if (DMA[d].HDMAIndirectAddressing)
 	{
 		ADD_CYCLES(SLOW_ONE_CYCLE << 1);
-		DMA[d].IndirectAddress = S9xGetWord((DMA[d].ABank << 16) + DMA[d].Address);
+		DMA[d].IndirectAddress = Table ? READ_WORD(Table + 1) : S9xGetWord((DMA[d].ABank << 16) + DMA[d].Address);
 		DMA[d].Address += 2;
 		HDMAMemPointers[d] = S9xGetMemPointer((DMA[d].IndirectBank << 16) + DMA[d].IndirectAddress);
 	}
 	else
-		HDMAMemPointers[d] = S9xGetMemPointer((DMA[d].ABank << 16) + DMA[d].Address);
+		HDMAMemPointers[d] = Table ? Table + 1 : S9xGetMemPointer((DMA[d].ABank << 16) + DMA[d].Address);
 
 	return (TRUE);
 }
@@ -294,6 +294,28 @@ static void DSP1_Op20 (void)
 #endif
 }
 
+// The inverse of every normalized coefficient (0x4000 - 0x7fff), worked out
+// once the way the DSP-1 does it: an initial guess from ROM and two rounds
+// of Newton's method.
+static int16	DSP1_InverseTable[0x4000];
+static bool8	DSP1_TablesBuilt = FALSE;
+
+static void DSP1_BuildTables (void)
+{
+	for (int c = 0x4000; c < 0x8000; c++)
+	{
+		int16	Coefficient = c;
+		int16	i = DSP1ROM[((Coefficient - 0x4000) >> 7) + 0x0065];
+
+		i = (i + (-i * (Coefficient * i >> 15) >> 15)) << 1;
+		i = (i + (-i * (Coefficient * i >> 15) >> 15)) << 1;
+
+		DSP1_InverseTable[c - 0x4000] = i;
+	}
+
+	DSP1_TablesBuilt = TRUE;
+}
+
 static void DSP1_Inverse (int16 Coefficient, int16 Exponent, int16 *iCoefficient, int16 *iExponent)
 {
 	// Step One: Division by Zero
@@ -341,14 +363,11 @@ static void DSP1_Inverse (int16 Coefficient, int16 Exponent, int16 *iCoefficient
 		}
 		else
 		{
-			// Step Five: Initial Guess
-			int16	i = DSP1ROM[((Coefficient - 0x4000) >> 7) + 0x0065];
-
-			// Step Six: Iterate "estimated" Newton's Method
-			i = (i + (-i * (Coefficient * i >> 15) >> 15)) << 1;
-			i = (i + (-i * (Coefficient * i >> 15) >> 15)) << 1;
+			// Step Five: Initial Guess and "estimated" Newton's Method, precomputed
+			if (!DSP1_TablesBuilt)
+				DSP1_BuildTables();
 
-			*iCoefficient = i * Sign;
+			*iCoefficient = DSP1_InverseTable[Coefficient - 0x4000] * Sign;
 		}
 
 		*iExponent = 1 - Exponent;
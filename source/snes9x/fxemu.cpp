@@ -25,7 +25,8 @@ void S9xInitSuperFX (void)
 	memset((uint8 *) &GSU, 0, sizeof(struct FxRegs_s));
 }
 
-void S9xResetSuperFX (void)
+// Sets the speed only, without resetting the GSU of a running game
+void S9xSetSuperFXSpeed (void)
 {
 	// FIXME: Snes9x only runs the SuperFX at the end of every line.
 	// 5823405 is a magic number that seems to work for most games.
@@ -34,6 +35,11 @@ void S9xResetSuperFX (void)
 	#else
 	SuperFX.speedPerLine = (uint32) (5823405 * ((1.0 / (float) Memory.ROMFramesPerSecond) / ((float) (Timings.V_Max)))); 
 	#endif
+}
+
+void S9xResetSuperFX (void)
+{
+	S9xSetSuperFXSpeed();
 	SuperFX.oneLineDone = FALSE;
 	SuperFX.vFlags = 0;
 	CPU.IRQExternal = FALSE;
@@ -27,6 +27,7 @@ extern struct FxInfo_s	SuperFX;
 
 void S9xInitSuperFX (void);
 void S9xResetSuperFX (void);
+void S9xSetSuperFXSpeed (void);
 void S9xSuperFXExec (void);
 void S9xSetSuperFX (uint8, uint16);
 uint8 S9xGetSuperFX (uint16);
@@ -52,6 +52,7 @@ bool8 S9xGraphicsInit (void)
 	GFX.RealPPL = GFX.Pitch >> 1;
 	IPPU.OBJChanged = TRUE;
 	Settings.BG_Forced = 0;
+	S9xInvalidateScreenRows(0, MAX_SNES_HEIGHT - 1);
 	S9xFixColourBrightness();
 	S9xBuildDirectColourMaps();
 
@@ -233,6 +234,9 @@ void S9xEndScreenRefresh (void)
 				S9xDisplayMessages(GFX.Screen, GFX.RealPPL, IPPU.RenderedScreenWidth, IPPU.RenderedScreenHeight, 1);
 
 			S9xDeinitUpdate(IPPU.RenderedScreenWidth, IPPU.RenderedScreenHeight);
+
+			GFX.DirtyFirstRow = MAX_SNES_HEIGHT;
+			GFX.DirtyLastRow = -1;
 		}
 	}
 	else
@@ -444,6 +448,150 @@ static inline void RenderScreen (bool8 sub)
 	DrawBackdrop();
 }
 
+// Each line remembers a hash of the PPU state it was drawn with, and the
+// VRAM/CGRAM/OAM generation at the time. Lines that would come out the same as
+// in the last frame are left alone in GFX.Screen, and the rows that did change
+// are collected in GFX.DirtyFirstRow/DirtyLastRow for the port.
+static struct
+{
+	uint32	Key[SNES_HEIGHT_EXTENDED];
+	uint32	Generation[SNES_HEIGHT_EXTENDED];
+	bool8	Valid[SNES_HEIGHT_EXTENDED];
+	bool8	Dirty[SNES_HEIGHT_EXTENDED];
+}	ScreenLines;
+
+static inline uint32 HashScreenState (uint32 hash, const void *data, int length)
+{
+	const uint8	*p = (const uint8 *) data;
+
+	for (int i = 0; i < length; i++)
+		hash = (hash ^ p[i]) * 16777619u;
+
+	return (hash);
+}
+
+static inline void MarkScreenRows (int first, int last)
+{
+	if (first < GFX.DirtyFirstRow)
+		GFX.DirtyFirstRow = first;
+	if (last > GFX.DirtyLastRow)
+		GFX.DirtyLastRow = last;
+}
+
+void S9xInvalidateScreenRows (int first, int last)
+{
+	MarkScreenRows(first, last);
+
+	if (first < 0)
+		first = 0;
+	if (last >= SNES_HEIGHT_EXTENDED)
+		last = SNES_HEIGHT_EXTENDED - 1;
+
+	for (int y = first; y <= last; y++)
+		ScreenLines.Valid[y] = FALSE;
+}
+
+static uint32 ScreenBatchKey (bool8 mosaic)
+{
+	uint32	hash = 2166136261u;
+
+	// The registers kept per line (scroll offsets and the Mode 7 matrix) are
+	// hashed separately, as are the VRAM address and CGRAM ports
+	hash = HashScreenState(hash, Memory.FillRAM + 0x2100, 2);	// INIDISP, OBSEL
+	hash = HashScreenState(hash, Memory.FillRAM + 0x2105, 8);	// BGMODE - BG34NBA
+	hash = HashScreenState(hash, Memory.FillRAM + 0x211a, 1);	// M7SEL
+	hash = HashScreenState(hash, Memory.FillRAM + 0x2123, 17);	// W12SEL - SETINI
+
+	bool8	evil = PPU.OAMPriorityRotation && (PPU.OAMFlip & PPU.OAMAddr & 1);
+	bool8	field = (IPPU.Interlace || IPPU.InterlaceOBJ) && GFX.InterlaceFrame;
+
+	uint32	state[] =
+	{
+		(uint32) (PPU.FixedColourRed | (PPU.FixedColourGreen << 5) | (PPU.FixedColourBlue << 10)),
+		(uint32) (PPU.FirstSprite | (evil << 8) | (field << 9)),
+		(uint32) (IPPU.DoubleWidthPixels | (IPPU.PseudoHires << 1) | (IPPU.InterlaceOBJ << 2)),
+		(uint32) (Settings.BG_Forced | (Settings.Transparency << 8) | (Settings.DisableGraphicWindows << 9)),
+		(uint32) Settings.MaxSpriteTilesPerLine,
+		(uint32) IPPU.RenderedScreenWidth,
+		PPU.ScreenHeight,
+		GFX.RealPPL,
+		// mosaic blocks start from the first line of the batch
+		mosaic ? (GFX.StartY << 16) | PPU.MosaicStart : 0
+	};
+
+	return (HashScreenState(hash, state, sizeof(state)));
+}
+
+static void CheckScreenLines (void)
+{
+	// Interlaced and double height images mix two fields, always draw them
+	bool8	redraw = GFX.DoInterlace || IPPU.DoubleHeightPixels;
+	bool8	mosaic = PPU.Mosaic > 1 && (PPU.BGMosaic[0] || PPU.BGMosaic[1] || PPU.BGMosaic[2] || PPU.BGMosaic[3]);
+	uint32	key = ScreenBatchKey(mosaic);
+	int		first = -1, last = -1;
+
+	for (uint32 y = GFX.StartY; y <= GFX.EndY; y++)
+	{
+		uint32	k = HashScreenState(key, &LineData[y], sizeof(LineData[y]));
+		if (PPU.BGMode == 7)
+			k = HashScreenState(k, &LineMatrixData[y], sizeof(LineMatrixData[y]));
+
+		ScreenLines.Dirty[y] = redraw || !ScreenLines.Valid[y] || ScreenLines.Key[y] != k || ScreenLines.Generation[y] != IPPU.ScreenGeneration;
+		ScreenLines.Key[y] = k;
+		ScreenLines.Generation[y] = IPPU.ScreenGeneration;
+		ScreenLines.Valid[y] = !redraw;
+
+		if (ScreenLines.Dirty[y])
+		{
+			if (first < 0)
+				first = y;
+			last = y;
+		}
+	}
+
+	if (first < 0)
+		return;
+
+	// A mosaic depends on where the batch starts, so it's drawn all or nothing
+	if (mosaic)
+	{
+		first = GFX.StartY;
+		last = GFX.EndY;
+		memset(ScreenLines.Dirty + first, TRUE, last - first + 1);
+	}
+
+	if (IPPU.DoubleHeightPixels)
+		MarkScreenRows(first * 2, last * 2 + 1);
+	else
+		MarkScreenRows(first, last);
+}
+
+static void RenderScreenLines (void)
+{
+	if (!PPU.ForcedBlanking)
+	{
+		if (PPU.BGMode == 5 || PPU.BGMode == 6 || IPPU.PseudoHires ||
+			((Memory.FillRAM[0x2130] & 0x30) != 0x30 && (Memory.FillRAM[0x2130] & 2) && (Memory.FillRAM[0x2131] & 0x3f) && (Memory.FillRAM[0x212d] & 0x1f)))
+			// If hires (Mode 5/6 or pseudo-hires) or math is to be done
+			// involving the subscreen, then we need to render the subscreen...
+			RenderScreen(TRUE);
+
+		RenderScreen(FALSE);
+	}
+	else
+	{
+		const uint16	black = BUILD_PIXEL(0, 0, 0);
+
+		GFX.S = GFX.Screen + GFX.StartY * GFX.PPL;
+		if (GFX.DoInterlace && GFX.InterlaceFrame)
+			GFX.S += GFX.RealPPL;
+
+		for (uint32 l = GFX.StartY; l <= GFX.EndY; l++, GFX.S += GFX.PPL)
+			for (int x = 0; x < IPPU.RenderedScreenWidth; x++)
+				GFX.S[x] = black;
+	}
+}
+
 void S9xUpdateScreen (void)
 {
 	if (IPPU.OBJChanged || IPPU.InterlaceOBJ)
@@ -502,6 +650,8 @@ void S9xUpdateScreen (void)
 						*q = *(q + 1) = *p;
 				}
 
+				S9xInvalidateScreenRows(0, (int) GFX.StartY - 1);
+
 				IPPU.DoubleWidthPixels = TRUE;
 				IPPU.RenderedScreenWidth = 512;
 			}
@@ -515,34 +665,141 @@ void S9xUpdateScreen (void)
 
 				for (int32 y = (int32) GFX.StartY - 2; y >= 0; y--)
 					memmove(GFX.Screen + (y + 1) * GFX.PPL, GFX.Screen + y * GFX.RealPPL, GFX.PPL * sizeof(uint16));
+
+				S9xInvalidateScreenRows(0, (int) GFX.StartY * 2 - 1);
 			}
 		}
 
 		if ((Memory.FillRAM[0x2130] & 0x30) != 0x30 && (Memory.FillRAM[0x2131] & 0x3f))
 			GFX.FixedColour = BUILD_PIXEL(IPPU.XB[PPU.FixedColourRed], IPPU.XB[PPU.FixedColourGreen], IPPU.XB[PPU.FixedColourBlue]);
+	}
 
-		if (PPU.BGMode == 5 || PPU.BGMode == 6 || IPPU.PseudoHires ||
-			((Memory.FillRAM[0x2130] & 0x30) != 0x30 && (Memory.FillRAM[0x2130] & 2) && (Memory.FillRAM[0x2131] & 0x3f) && (Memory.FillRAM[0x212d] & 0x1f)))
-			// If hires (Mode 5/6 or pseudo-hires) or math is to be done
-			// involving the subscreen, then we need to render the subscreen...
-			RenderScreen(TRUE);
+	CheckScreenLines();
 
-		RenderScreen(FALSE);
+	// Draw each run of changed lines as its own batch
+	uint32	StartY = GFX.StartY, EndY = GFX.EndY;
+
+	for (uint32 y = StartY; y <= EndY; y++)
+	{
+		if (!ScreenLines.Dirty[y])
+			continue;
+
+		GFX.StartY = y;
+		while (y < EndY && ScreenLines.Dirty[y + 1])
+			y++;
+		GFX.EndY = y;
+
+		RenderScreenLines();
+	}
+
+	GFX.StartY = StartY;
+	GFX.EndY = EndY;
+
+	IPPU.PreviousLine = IPPU.CurrentLine;
+}
+
+// Sprite geometry is cached between frames, and each line keeps a bitmask of
+// the sprites that cover it. Only the sprites written through OAM since the
+// last call (IPPU.OBJDirtyFirst..OBJDirtyLast) are moved between lines, and
+// only the lines they touched get their sprite lists rebuilt.
+static struct
+{
+	uint32	LineMask[SNES_HEIGHT_EXTENDED][4];
+	uint8	LineDirty[SNES_HEIGHT_EXTENDED];
+	uint8	LineRTO[SNES_HEIGHT_EXTENDED];	// range/time over flags of each line alone
+	uint8	VPos[128];
+	uint8	Lines[128];						// rows the sprite covers, 0 if it's off screen
+	uint8	LineXor[128];					// flips the row for VFlip sprites
+	uint8	VisibleTiles[2][128];			// normal and FirstSprite+Y priority
+	int		SizeSelect;
+	int		StartLine;
+	int		Inc;
+	int		FirstSprite;
+	int		MaxTiles;
+}	OBJCache = { {{ 0 }}, { 0 }, { 0 }, { 0 }, { 0 }, { 0 }, {{ 0 }}, -1, 0, 0, -1, 0 };
+
+static inline uint8 OBJVisibleTiles (int HPos, int Width, int Edge)
+{
+	if (HPos < 0)
+		return ((Width + HPos + 7) >> 3);
+	if (HPos + Width >= Edge)
+		return ((Edge - HPos + 7) >> 3);
+	return (Width >> 3);
+}
+
+static void SetOBJLines (int S, bool8 on)
+{
+	uint32	bit = 1 << (S & 31);
+	int		w = S >> 5;
+	uint8	Y = OBJCache.VPos[S];
+
+	for (int k = 0; k < OBJCache.Lines[S]; k++, Y++)
+	{
+		if (Y >= SNES_HEIGHT_EXTENDED)
+			continue;
+
+		if (on)
+			OBJCache.LineMask[Y][w] |= bit;
+		else
+			OBJCache.LineMask[Y][w] &= ~bit;
+
+		OBJCache.LineDirty[Y] = TRUE;
+	}
+}
+
+static void UpdateOBJ (int S, int SmallWidth, int SmallHeight, int LargeWidth, int LargeHeight)
+{
+	int		Width, Height, Lines;
+	uint8	Tiles[2] = { 0, 0 };
+
+	if (PPU.OBJ[S].Size)
+	{
+		Width = LargeWidth;
+		Height = LargeHeight;
 	}
 	else
 	{
-		const uint16	black = BUILD_PIXEL(0, 0, 0);
+		Width = SmallWidth;
+		Height = SmallHeight;
+	}
 
-		GFX.S = GFX.Screen + GFX.StartY * GFX.PPL;
-		if (GFX.DoInterlace && GFX.InterlaceFrame)
-			GFX.S += GFX.RealPPL;
+	GFX.OBJWidths[S] = Width;
 
-		for (uint32 l = GFX.StartY; l <= GFX.EndY; l++, GFX.S += GFX.PPL)
-			for (int x = 0; x < IPPU.RenderedScreenWidth; x++)
-				GFX.S[x] = black;
+	int	HPos = PPU.OBJ[S].HPos;
+	if (HPos == -256)
+	{
+		// Shown at 0 by the normal case, and at 256 by the FirstSprite+Y case
+		Tiles[0] = Width >> 3;
+		Tiles[1] = 1;
+		Lines = (Height - OBJCache.StartLine + OBJCache.Inc - 1) / OBJCache.Inc;
 	}
+	else if (HPos > -Width)
+	{
+		Tiles[0] = OBJVisibleTiles(HPos, Width, 256);
+		Tiles[1] = OBJVisibleTiles(HPos, Width, 257);
+		Lines = (Height - OBJCache.StartLine + OBJCache.Inc - 1) / OBJCache.Inc;
+	}
+	else
+		Lines = 0;
 
-	IPPU.PreviousLine = IPPU.CurrentLine;
+	// Yes, Width not Height. It so happens that the sprites with H=2*W flip
+	// as two WxW sprites.
+	uint8	LineXor = PPU.OBJ[S].VFlip ? Width - 1 : 0;
+	uint8	VPos = (uint8) (PPU.OBJ[S].VPos & 0xff);
+
+	// Sprites that moved sideways or changed tiles or palette keep the same
+	// line lists
+	if (Lines == OBJCache.Lines[S] && VPos == OBJCache.VPos[S] && LineXor == OBJCache.LineXor[S] &&
+		Tiles[0] == OBJCache.VisibleTiles[0][S] && Tiles[1] == OBJCache.VisibleTiles[1][S])
+		return;
+
+	SetOBJLines(S, FALSE);
+	OBJCache.VPos[S] = VPos;
+	OBJCache.Lines[S] = Lines;
+	OBJCache.LineXor[S] = LineXor;
+	OBJCache.VisibleTiles[0][S] = Tiles[0];
+	OBJCache.VisibleTiles[1][S] = Tiles[1];
+	SetOBJLines(S, TRUE);
 }
 
 static void SetupOBJ (void)
@@ -597,184 +854,101 @@ static void SetupOBJ (void)
 
 	int startline = (IPPU.InterlaceOBJ && GFX.InterlaceFrame) ? 1 : 0;
 
-	// OK, we have three cases here. Either there's no priority, priority is
-	// normal FirstSprite, or priority is FirstSprite+Y. The first two are
-	// easy, the last is somewhat more ... interesting. So we split them up.
-
-	int		Height;
-	uint8	S;
-	int sprite_limit = (Settings.MaxSpriteTilesPerLine == 128) ? 128 : 32;
-
-	if (!PPU.OAMPriorityRotation || !(PPU.OAMFlip & PPU.OAMAddr & 1)) // normal case
+	if (PPU.OBJSizeSelect != OBJCache.SizeSelect || startline != OBJCache.StartLine || inc != OBJCache.Inc)
 	{
-		uint8	LineOBJ[SNES_HEIGHT_EXTENDED];
-		memset(LineOBJ, 0, sizeof(LineOBJ));
-
-		for (int i = 0; i < SNES_HEIGHT_EXTENDED; i++)
-		{
-			GFX.OBJLines[i].RTOFlags = 0;
-			GFX.OBJLines[i].Tiles = Settings.MaxSpriteTilesPerLine;
-			for (int j = 0; j < sprite_limit; j++)
-				GFX.OBJLines[i].OBJ[j].Sprite = -1;
-		}
-
-		uint8	FirstSprite = PPU.FirstSprite;
-		S = FirstSprite;
-
-		do
-		{
-			if (PPU.OBJ[S].Size)
-			{
-				GFX.OBJWidths[S] = LargeWidth;
-				Height = LargeHeight;
-			}
-			else
-			{
-				GFX.OBJWidths[S] = SmallWidth;
-				Height = SmallHeight;
-			}
-
-			int	HPos = PPU.OBJ[S].HPos;
-			if (HPos == -256)
-				HPos = 0;
+		memset(OBJCache.LineMask, 0, sizeof(OBJCache.LineMask));
+		memset(OBJCache.Lines, 0, sizeof(OBJCache.Lines));
+		memset(OBJCache.LineDirty, TRUE, sizeof(OBJCache.LineDirty));
+		OBJCache.SizeSelect = PPU.OBJSizeSelect;
+		OBJCache.StartLine = startline;
+		OBJCache.Inc = inc;
+		IPPU.OBJDirtyFirst = 0;
+		IPPU.OBJDirtyLast = 127;
+	}
 
-			if (HPos > -GFX.OBJWidths[S] && HPos <= 256)
-			{
-				if (HPos < 0)
-					GFX.OBJVisibleTiles[S] = (GFX.OBJWidths[S] + HPos + 7) >> 3;
-				else if (HPos + GFX.OBJWidths[S] > 255)
-					GFX.OBJVisibleTiles[S] = (256 - HPos + 7) >> 3;
-				else
-					GFX.OBJVisibleTiles[S] = GFX.OBJWidths[S] >> 3;
+	for (int S = IPPU.OBJDirtyFirst; S <= IPPU.OBJDirtyLast; S++)
+		UpdateOBJ(S, SmallWidth, SmallHeight, LargeWidth, LargeHeight);
 
-				for (uint8 line = startline, Y = (uint8) (PPU.OBJ[S].VPos & 0xff); line < Height; Y++, line += inc)
-				{
-					if (Y >= SNES_HEIGHT_EXTENDED)
-						continue;
+	IPPU.OBJDirtyFirst = 128;
+	IPPU.OBJDirtyLast = -1;
 
-					if (LineOBJ[Y] >= sprite_limit)
-					{
-						GFX.OBJLines[Y].RTOFlags |= 0x40;
-						continue;
-					}
+	// OK, we have three cases here. Either there's no priority, priority is
+	// normal FirstSprite, or priority is FirstSprite+Y. They only differ in
+	// which sprite each line starts from, and how a sprite at -256 is clipped.
 
-					GFX.OBJLines[Y].Tiles -= GFX.OBJVisibleTiles[S];
-					if (GFX.OBJLines[Y].Tiles < 0)
-						GFX.OBJLines[Y].RTOFlags |= 0x80;
+	int		sprite_limit = (Settings.MaxSpriteTilesPerLine == 128) ? 128 : 32;
+	bool8	evil = PPU.OAMPriorityRotation && (PPU.OAMFlip & PPU.OAMAddr & 1);
+	int		FirstSprite = evil ? PPU.FirstSprite | 0x80 : PPU.FirstSprite;
 
-					GFX.OBJLines[Y].OBJ[LineOBJ[Y]].Sprite = S;
-					if (PPU.OBJ[S].VFlip)
-						// Yes, Width not Height. It so happens that the
-						// sprites with H=2*W flip as two WxW sprites.
-						GFX.OBJLines[Y].OBJ[LineOBJ[Y]].Line = line ^ (GFX.OBJWidths[S] - 1);
-					else
-						GFX.OBJLines[Y].OBJ[LineOBJ[Y]].Line = line;
+	if (FirstSprite != OBJCache.FirstSprite || Settings.MaxSpriteTilesPerLine != OBJCache.MaxTiles)
+	{
+		memset(OBJCache.LineDirty, TRUE, sizeof(OBJCache.LineDirty));
+		OBJCache.FirstSprite = FirstSprite;
+		OBJCache.MaxTiles = Settings.MaxSpriteTilesPerLine;
+	}
 
-					LineOBJ[Y]++;
-				}
-			}
+	memcpy(GFX.OBJVisibleTiles, OBJCache.VisibleTiles[evil ? 1 : 0], sizeof(GFX.OBJVisibleTiles));
 
-			S = (S + 1) & 0x7f;
-		} while (S != FirstSprite);
+	uint8	RTOFlags = 0;
 
-		for (int Y = 1; Y < SNES_HEIGHT_EXTENDED; Y++)
-			GFX.OBJLines[Y].RTOFlags |= GFX.OBJLines[Y - 1].RTOFlags;
-	}
-	else // evil FirstSprite+Y case
+	for (int Y = 0; Y < SNES_HEIGHT_EXTENDED; Y++)
 	{
-		// First, find out which sprites are on which lines
-		uint8 OBJOnLine[SNES_HEIGHT_EXTENDED][128];
-		// memset(OBJOnLine, 0, sizeof(OBJOnLine));
-		/* Hold on here, that's a lot of bytes to initialise at once!
-		 * So we only initialise them per line, as needed. [Neb]
-		 * Bonus: We can quickly avoid looping if a line has no OBJs.
-		 */
-        bool8 AnyOBJOnLine[SNES_HEIGHT_EXTENDED];
-        memset(AnyOBJOnLine, FALSE, sizeof(AnyOBJOnLine)); // better
-
-		for (S = 0; S < 128; S++)
+		if (OBJCache.LineDirty[Y])
 		{
-			if (PPU.OBJ[S].Size)
-			{
-				GFX.OBJWidths[S] = LargeWidth;
-				Height = LargeHeight;
-			}
-			else
-			{
-				GFX.OBJWidths[S] = SmallWidth;
-				Height = SmallHeight;
-			}
+			uint32	*mask = OBJCache.LineMask[Y];
+			uint8	LineRTO = 0;
+			int		j = 0;
 
-			int	HPos = PPU.OBJ[S].HPos;
-			if (HPos == -256)
-				HPos = 256;
+			OBJCache.LineDirty[Y] = FALSE;
+			GFX.OBJLines[Y].Tiles = Settings.MaxSpriteTilesPerLine;
 
-			if (HPos > -GFX.OBJWidths[S] && HPos <= 256)
+			if (mask[0] | mask[1] | mask[2] | mask[3])
 			{
-				if (HPos < 0)
-					GFX.OBJVisibleTiles[S] = (GFX.OBJWidths[S] + HPos + 7) >> 3;
-				else if (HPos + GFX.OBJWidths[S] >= 257)
-					GFX.OBJVisibleTiles[S] = (257 - HPos + 7) >> 3;
-				else
-					GFX.OBJVisibleTiles[S] = GFX.OBJWidths[S] >> 3;
+				// Walk the sprites on this line in priority order, wrapping
+				// around from the first sprite
+				int		First = evil ? (PPU.FirstSprite + Y) & 0x7f : PPU.FirstSprite;
+				int		w0 = First >> 5;
+				uint32	upper = ~0U << (First & 31);
 
-				for (uint8 line = startline, Y = (uint8) (PPU.OBJ[S].VPos & 0xff); line < Height; Y++, line += inc)
+				for (int n = 0; n <= 4; n++)
 				{
-					if (Y >= SNES_HEIGHT_EXTENDED)
-						continue;
-
-					if (!AnyOBJOnLine[Y]) {
-						memset(OBJOnLine[Y], 0, sizeof(OBJOnLine[Y]));
-						AnyOBJOnLine[Y] = TRUE;
-					}
+					int		w = (w0 + n) & 3;
+					uint32	bits = mask[w];
 
-					if (PPU.OBJ[S].VFlip)
-						// Yes, Width not Height. It so happens that the
-						// sprites with H=2*W flip as two WxW sprites.
-						OBJOnLine[Y][S] = (line ^ (GFX.OBJWidths[S] - 1)) | 0x80;
-					else
-						OBJOnLine[Y][S] = line | 0x80;
-				}
-			}
-		}
+					if (n == 0)
+						bits &= upper;
+					else if (n == 4)
+						bits &= ~upper;
 
-		// Now go through and pull out those OBJ that are actually visible.
-		int	j;
-		for (int Y = 0; Y < SNES_HEIGHT_EXTENDED; Y++)
-		{
-			GFX.OBJLines[Y].RTOFlags = Y ? GFX.OBJLines[Y - 1].RTOFlags : 0;
-			GFX.OBJLines[Y].Tiles = Settings.MaxSpriteTilesPerLine;
-
-			uint8	FirstSprite = (PPU.FirstSprite + Y) & 0x7f;
-			S = FirstSprite;
-			j = 0;
-
-			if (AnyOBJOnLine[Y])
-			{
-				do
-				{
-					if (OBJOnLine[Y][S])
+					for (; bits; bits &= bits - 1)
 					{
 						if (j >= sprite_limit)
 						{
-							GFX.OBJLines[Y].RTOFlags |= 0x40;
+							LineRTO |= 0x40;
+							n = 4;
 							break;
 						}
 
+						int	S = (w << 5) + __builtin_ctz(bits);
+
 						GFX.OBJLines[Y].Tiles -= GFX.OBJVisibleTiles[S];
 						if (GFX.OBJLines[Y].Tiles < 0)
-							GFX.OBJLines[Y].RTOFlags |= 0x80;
+							LineRTO |= 0x80;
+
 						GFX.OBJLines[Y].OBJ[j].Sprite = S;
-						GFX.OBJLines[Y].OBJ[j++].Line = OBJOnLine[Y][S] & ~0x80;
+						GFX.OBJLines[Y].OBJ[j++].Line = (startline + (uint8) (Y - OBJCache.VPos[S]) * inc) ^ OBJCache.LineXor[S];
 					}
-
-					S = (S + 1) & 0x7f;
-				} while (S != FirstSprite);
+				}
 			}
 
 			if (j < sprite_limit)
 				GFX.OBJLines[Y].OBJ[j].Sprite = -1;
+
+			OBJCache.LineRTO[Y] = LineRTO;
 		}
+
+		RTOFlags |= OBJCache.LineRTO[Y];
+		GFX.OBJLines[Y].RTOFlags = RTOFlags;
 	}
 
 	IPPU.OBJChanged = FALSE;
@@ -1775,6 +1949,9 @@ void S9xDisplayChar (uint16 *s, uint8 c)
 
 	int	line   = ((c - 32) >> 4) * font_height;
 	int	offset = ((c - 32) & 15) * font_width;
+	int	row    = (s - GFX.Screen) / (int) GFX.RealPPL;
+
+	S9xInvalidateScreenRows(row, row + font_height - 1);
 
 	for (int h = 0; h < font_height; h++, line++, s += GFX.RealPPL - font_width)
 	{
@@ -2011,6 +2188,13 @@ static void DisplayPressedKeys (void)
 
 static void DisplayWatchedAddresses (void)
 {
+	if (!watches[0].on)
+		return;
+
+	uint8	*watch_ram = S9xGetWatchRAM();
+	if (!watch_ram)
+		return;
+
 	for (unsigned int i = 0; i < sizeof(watches) / sizeof(watches[0]); i++)
 	{
 		if (!watches[i].on)
@@ -2020,7 +2204,7 @@ static void DisplayWatchedAddresses (void)
 		char	buf[64];
 
 		for (int r = 0; r < watches[i].size; r++)
-			displayNumber += (Cheat.CWatchRAM[(watches[i].address - 0x7E0000) + r]) << (8 * r);
+			displayNumber += (watch_ram[(watches[i].address - 0x7E0000) + r]) << (8 * r);
 
 		if (watches[i].format == 1)
 			sprintf(buf, "%s,%du = %u", watches[i].desc, watches[i].size, (unsigned int) displayNumber);
@@ -2109,6 +2293,8 @@ void S9xDrawCrosshair (const char *crosshair, uint8 fgcolor, uint8 bgcolor, int1
 
 	uint16	*s = GFX.Screen + y * (int32)GFX.RealPPL + x;
 
+	S9xInvalidateScreenRows(y < 0 ? 0 : y, y + 15 * rx - 1);
+
 	for (r = 0; r < 15 * rx; r++, s += GFX.RealPPL - 15 * cx)
 	{
 		if (y + r < 0)
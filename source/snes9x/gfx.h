@@ -32,6 +32,8 @@ struct SGFX
 	uint8	InterlaceFrame;
 	uint32	StartY;
 	uint32	EndY;
+	int32	DirtyFirstRow;		// rows of Screen redrawn since the last S9xDeinitUpdate,
+	int32	DirtyLastRow;		// none when DirtyFirstRow > DirtyLastRow
 	bool8	ClipColors;
 	uint8	OBJWidths[128];
 	uint8	OBJVisibleTiles[128];
@@ -204,7 +206,9 @@ void S9xEndScreenRefresh (void);
 void S9xBuildDirectColourMaps (void);
 void RenderLine (uint8);
 void S9xComputeClipWindows (void);
+void S9xResetClipWindowCache (void);
 void S9xDisplayChar (uint16 *, uint8);
+void S9xInvalidateScreenRows (int, int);
 void S9xGraphicsScreenResize (void);
 // called automatically unless Settings.AutoDisplayMessages is false
 void S9xDisplayMessages (uint16 *, int, int, int, int);
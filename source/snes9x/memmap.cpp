@@ -7,6 +7,7 @@
 #ifdef GEKKO
 #include <gccore.h>
 #include <malloc.h>
+#define ROM_HASH_THREAD
 #endif
 
 #include <string>
@@ -45,6 +46,8 @@
 #include "../filebrowser.h"
 extern int WiiFileLoader();
 extern void WiiSetupCheats();
+extern bool isBSX();
+extern bool bsxBiosLoadFailed;
 #endif
 #ifdef USE_VM
 	#include "vmalloc.h"
@@ -913,11 +916,6 @@ bool8 CMemory::Init (void)
     RAM	 = (uint8 *) memalign(32,0x20000);
     SRAM = (uint8 *) memalign(32,0x80000);
     VRAM = (uint8 *) memalign(32,0x10000);
-#ifdef USE_VM
-	ROM  = (uint8 *) vm_malloc(MAX_ROM_SIZE + 0x200 + 0x8000);
-#else
-    ROM  = (uint8 *) memalign(32,MAX_ROM_SIZE + 0x200 + 0x8000);
-#endif
 
 	IPPU.TileCache[TILE_2BIT]       = (uint8 *) memalign(32,MAX_2BIT_TILES * 64);
 	IPPU.TileCache[TILE_4BIT]       = (uint8 *) memalign(32,MAX_4BIT_TILES * 64);
@@ -935,6 +933,15 @@ bool8 CMemory::Init (void)
 	IPPU.TileCached[TILE_4BIT_EVEN] = (uint8 *) memalign(32,MAX_4BIT_TILES);
 	IPPU.TileCached[TILE_4BIT_ODD]  = (uint8 *) memalign(32,MAX_4BIT_TILES);
 
+	// ROM is allocated last: it is by far the largest buffer and mostly cold,
+	// so if MEM1 runs out it is the one that spills into MEM2, not the tile
+	// caches. BIOSROM, BSRAM, C4RAM and OBC1RAM live in its unused tail.
+#ifdef USE_VM
+	ROM  = (uint8 *) vm_malloc(MAX_ROM_SIZE + 0x200 + 0x8000);
+#else
+    ROM  = (uint8 *) memalign(32,MAX_ROM_SIZE + 0x200 + 0x8000);
+#endif
+
 	if (!RAM || !SRAM || !VRAM || !ROM ||
 		!IPPU.TileCache[TILE_2BIT]       ||
 		!IPPU.TileCache[TILE_4BIT]       ||
@@ -958,15 +965,12 @@ bool8 CMemory::Init (void)
 	memset(RAM, 0,  0x20000);
 	memset(SRAM, 0, 0x80000);
 	memset(VRAM, 0, 0x10000);
-	memset(ROM, 0,  MAX_ROM_SIZE + 0x200 + 0x8000);
 
-	memset(IPPU.TileCache[TILE_2BIT], 0,       MAX_2BIT_TILES * 64);
-	memset(IPPU.TileCache[TILE_4BIT], 0,       MAX_4BIT_TILES * 64);
-	memset(IPPU.TileCache[TILE_8BIT], 0,       MAX_8BIT_TILES * 64);
-	memset(IPPU.TileCache[TILE_2BIT_EVEN], 0,  MAX_2BIT_TILES * 64);
-	memset(IPPU.TileCache[TILE_2BIT_ODD], 0,   MAX_2BIT_TILES * 64);
-	memset(IPPU.TileCache[TILE_4BIT_EVEN], 0,  MAX_4BIT_TILES * 64);
-	memset(IPPU.TileCache[TILE_4BIT_ODD], 0,   MAX_4BIT_TILES * 64);
+	// The ROM image area is cleared past the loaded ROM at load time, and
+	// the tile caches are only read once TileCached says they're filled,
+	// so only FillRAM and the slack after the ROM need clearing here.
+	memset(ROM, 0, 0x8000);
+	memset(ROM + 0x8000 + MAX_ROM_SIZE, 0, 0x200);
 
 	memset(IPPU.TileCached[TILE_2BIT], 0,      MAX_2BIT_TILES);
 	memset(IPPU.TileCached[TILE_4BIT], 0,      MAX_4BIT_TILES);
@@ -1004,6 +1008,8 @@ bool8 CMemory::Init (void)
 
 void CMemory::Deinit (void)
 {
+	WaitForROMHash();
+
 	if (RAM)
 	{
 		free(RAM);
@@ -1048,6 +1054,8 @@ void CMemory::Deinit (void)
 		}
 	}
 
+	S9xDeinitSDD1();
+
 	Safe(NULL);
 	SafeANK(NULL);
 }
@@ -1397,18 +1405,27 @@ uint32 CMemory::FileLoader (uint8 *buffer, const char *filename, uint32 maxsize)
 	return ((uint32) totalSize);
 }
 
+// Only the part of the ROM buffer that the new image didn't overwrite has to
+// be cleared. Patches and the special chip RAMs in the tail rely on it.
+static void ClearROMTail (uint8 *rom, uint32 size, uint32 end = CMemory::MAX_ROM_SIZE)
+{
+	if (size < end)
+		memset(rom + size, 0, end - size);
+}
+
 bool8 CMemory::LoadROMMem (const uint8 *source, uint32 sourceSize)
 {
     if(!source || sourceSize > MAX_ROM_SIZE)
         return FALSE;
 
+    WaitForROMHash();
     strcpy(ROMFilename,"MemoryROM");
 
     do
     {
-        memset(ROM,0, MAX_ROM_SIZE);
         memset(&Multi, 0,sizeof(Multi));
         memcpy(ROM,source,sourceSize);
+        ClearROMTail(ROM, sourceSize);
     }
     while(!LoadROMInt(sourceSize));
 
@@ -1421,12 +1438,12 @@ bool8 CMemory::LoadROM (const char *filename)
         return FALSE;
 
     S9xResetSaveTimer(FALSE); // reset oops timer here so that .oops file has rom name of previous rom
+    WaitForROMHash();
 	
     int32 totalFileSize;
 
     do
     {
-        memset(ROM,0, MAX_ROM_SIZE);
         memset(&Multi, 0,sizeof(Multi));
         
         #ifdef GEKKO
@@ -1438,6 +1455,19 @@ bool8 CMemory::LoadROM (const char *filename)
         if (!totalFileSize)
             return (FALSE);
 
+#ifdef GEKKO
+        // WiiFileLoader has already loaded the BS-X BIOS into BIOSROM
+        uint32 bios = BIOSROM - ROM;
+
+        if (isBSX() && !bsxBiosLoadFailed && (uint32) totalFileSize <= bios)
+        {
+            ClearROMTail(ROM, totalFileSize, bios);
+            ClearROMTail(ROM, bios + 0x100000);
+        }
+        else
+#endif
+        ClearROMTail(ROM, totalFileSize);
+
         CheckForAnyPatch(filename, HeaderCount != 0, totalFileSize);
     }
     while(!LoadROMInt(totalFileSize));
@@ -1674,6 +1704,7 @@ bool8 CMemory::LoadMultiCartMem (const uint8 *sourceA, uint32 sourceASize,
                                  const uint8 *bios, uint32 biosSize)
 {
     uint32 offset = 0;
+    WaitForROMHash();
     memset(ROM, 0, MAX_ROM_SIZE);
 	memset(&Multi, 0, sizeof(Multi));
 
@@ -1707,6 +1738,7 @@ bool8 CMemory::LoadMultiCartMem (const uint8 *sourceA, uint32 sourceASize,
 bool8 CMemory::LoadMultiCart (const char *cartA, const char *cartB)
 {
     S9xResetSaveTimer(FALSE); // reset oops timer here so that .oops file has rom name of previous rom
+    WaitForROMHash();
 	
     memset(ROM, 0, MAX_ROM_SIZE);
 	memset(&Multi, 0, sizeof(Multi));
@@ -2269,6 +2301,83 @@ void CMemory::ParseSNESHeader (uint8 *RomHeader)
 	}
 }
 
+// The SHA-256 of the ROM is only needed by the cheat database, so it is
+// computed on a low priority thread while the game starts instead of
+// stalling every load. ROM must not change until WaitForROMHash().
+
+#ifdef ROM_HASH_THREAD
+#define ROM_HASH_PRIORITY	40
+
+static lwp_t	ROMHashThread = LWP_THREAD_NULL;
+#endif
+
+static struct
+{
+	const uint8	*data;
+	uint32		size;
+	int32		patch;	// offset of the uCONSRT bytes in a BS dump, or -1
+	uint8		*hash;
+}	ROMHash;
+
+static void HashROM (void)
+{
+	static const uint8	uCONSRT[2] = { 0x42, 0x00 };
+	SHA256_CTX			ctx;
+	uint32				size = ROMHash.size;
+
+	sha256_init(&ctx);
+
+	if (ROMHash.patch >= 0 && (uint32) ROMHash.patch < size)
+	{
+		// Hash as if the BS dump had been converted, without touching ROM
+		uint32	p = ROMHash.patch;
+		uint32	n = min(size - p, sizeof(uCONSRT));
+
+		sha256_update(&ctx, ROMHash.data, p);
+		sha256_update(&ctx, uCONSRT, n);
+		sha256_update(&ctx, ROMHash.data + p + n, size - p - n);
+	}
+	else
+		sha256_update(&ctx, ROMHash.data, size);
+
+	sha256_final(&ctx, ROMHash.hash);
+}
+
+#ifdef ROM_HASH_THREAD
+static void * ROMHashThreadFunc (void *)
+{
+	HashROM();
+	return (NULL);
+}
+#endif
+
+static void StartROMHash (const uint8 *data, uint32 size, int32 patch, uint8 *hash)
+{
+	ROMHash.data = data;
+	ROMHash.size = size;
+	ROMHash.patch = patch;
+	ROMHash.hash = hash;
+
+#ifdef ROM_HASH_THREAD
+	if (LWP_CreateThread(&ROMHashThread, ROMHashThreadFunc, NULL, NULL, 0, ROM_HASH_PRIORITY) == 0)
+		return;
+	ROMHashThread = LWP_THREAD_NULL;
+#endif
+
+	HashROM();
+}
+
+void CMemory::WaitForROMHash (void)
+{
+#ifdef ROM_HASH_THREAD
+	if (ROMHashThread != LWP_THREAD_NULL)
+	{
+		LWP_JoinThread(ROMHashThread, NULL);
+		ROMHashThread = LWP_THREAD_NULL;
+	}
+#endif
+}
+
 void CMemory::InitROM (void)
 {
 	Settings.SuperFX = FALSE;
@@ -2554,11 +2663,11 @@ void CMemory::InitROM (void)
 
 	//// Build more ROM information
 
-	// CRC32
+	// CRC32, needed right away for the ROM info and game profiles
 	if (!Settings.BS || Settings.BSXItself) // Not BS Dump
 	{
 		ROMCRC32 = caCRC32(ROM, CalculatedSize);
-		sha256sum(ROM, CalculatedSize, ROMSHA256);
+		StartROMHash(ROM, CalculatedSize, -1, ROMSHA256);
 	}
 	else // Convert to correct format before scan
 	{
@@ -2571,10 +2680,10 @@ void CMemory::InitROM (void)
 		ROM[offset + 23] = 0x00;
 		// Calc
 		ROMCRC32 = caCRC32(ROM, CalculatedSize);
-		sha256sum(ROM, CalculatedSize, ROMSHA256);
 		// Convert back
 		ROM[offset + 22] = BSMagic0;
 		ROM[offset + 23] = BSMagic1;
+		StartROMHash(ROM, CalculatedSize, offset + 22, ROMSHA256);
 	}
 
 	// NTSC/PAL
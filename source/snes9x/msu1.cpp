@@ -4,6 +4,12 @@
    For further information, consult the LICENSE file in the root directory.
 \*****************************************************************************/
 
+#ifdef GEKKO
+#include <gccore.h>
+#include <unistd.h>
+#define MSU1_AUDIO_THREAD
+#endif
+
 #include "snes9x.h"
 #include "memmap.h"
 #include "display.h"
@@ -20,6 +26,219 @@ size_t partial_frames;
 // Sample buffer
 int16 *bufPos, *bufBegin, *bufEnd;
 
+// Audio is read ahead into a ring of chunks, so that the emulation thread
+// never waits on the file. Each chunk remembers where in the track it came
+// from; when the reader hits the end of a repeating track the next chunk
+// simply starts at the loop point.
+#define MSU1_AUDIO_CHUNK_SIZE	4096
+#define MSU1_AUDIO_CHUNKS		16
+
+struct MSU1AudioChunk
+{
+	uint32	pos;		// track position of data[0]
+	uint32	size;
+	bool8	end;		// the track stops after this chunk
+	uint8	data[MSU1_AUDIO_CHUNK_SIZE];
+};
+
+static MSU1AudioChunk audioChunks[MSU1_AUDIO_CHUNKS];
+static int		audioChunkHead;		// next chunk to play
+static int		audioChunkCount;
+static uint32	audioChunkOffset;	// bytes already played from the head chunk
+static uint32	audioReadPos;		// track position the reader continues from
+static bool8	audioReadEnded;
+static uint32	audioGeneration;	// bumped whenever the ring is flushed
+static uint32	audioStreamPos;		// current position of audioStream
+
+#ifdef MSU1_AUDIO_THREAD
+#define MSU1_AUDIO_PRIORITY		66
+
+static mutex_t	audioRingLock   = LWP_MUTEX_NULL;	// guards the ring, held briefly
+static mutex_t	audioStreamLock = LWP_MUTEX_NULL;	// guards audioStream, held while reading
+static lwp_t	audioThread     = LWP_THREAD_NULL;
+#endif
+
+static void LockAudioRing()
+{
+#ifdef MSU1_AUDIO_THREAD
+	if (audioRingLock == LWP_MUTEX_NULL)
+		LWP_MutexInit(&audioRingLock, false);
+	LWP_MutexLock(audioRingLock);
+#endif
+}
+
+static void UnlockAudioRing()
+{
+#ifdef MSU1_AUDIO_THREAD
+	LWP_MutexUnlock(audioRingLock);
+#endif
+}
+
+static void LockAudioStream()
+{
+#ifdef MSU1_AUDIO_THREAD
+	if (audioStreamLock == LWP_MUTEX_NULL)
+		LWP_MutexInit(&audioStreamLock, false);
+	LWP_MutexLock(audioStreamLock);
+#endif
+}
+
+static void UnlockAudioStream()
+{
+#ifdef MSU1_AUDIO_THREAD
+	LWP_MutexUnlock(audioStreamLock);
+#endif
+}
+
+// Drops everything read ahead and restarts the reader at pos
+static void AudioFlush(uint32 pos)
+{
+	LockAudioRing();
+	audioChunkHead = 0;
+	audioChunkCount = 0;
+	audioChunkOffset = 0;
+	audioReadPos = pos;
+	audioReadEnded = FALSE;
+	audioGeneration++;
+	UnlockAudioRing();
+}
+
+// Reads the next chunk of the track. Returns false if there was nothing to do
+static bool AudioFillChunk()
+{
+	LockAudioRing();
+
+	if (!audioStream || audioReadEnded || audioChunkCount == MSU1_AUDIO_CHUNKS)
+	{
+		UnlockAudioRing();
+		return false;
+	}
+
+	uint32	pos = audioReadPos;
+	uint32	generation = audioGeneration;
+	// the free slot isn't touched by the player, and a flush only makes it free again
+	MSU1AudioChunk	*chunk = &audioChunks[(audioChunkHead + audioChunkCount) % MSU1_AUDIO_CHUNKS];
+
+	UnlockAudioRing();
+
+	size_t	bytes_read = 0;
+
+	LockAudioStream();
+	if (audioStream)
+	{
+		if (audioStreamPos != pos)
+			REVERT_STREAM(audioStream, pos, 0);
+		bytes_read = READ_STREAM((char *)chunk->data, MSU1_AUDIO_CHUNK_SIZE, audioStream);
+		audioStreamPos = pos + bytes_read;
+	}
+	UnlockAudioStream();
+
+	LockAudioRing();
+
+	if (generation == audioGeneration)
+	{
+		uint32	size = bytes_read & ~3;	// a partial sample at the end isn't played
+
+		chunk->pos = pos;
+		chunk->size = size;
+		chunk->end = FALSE;
+		audioReadPos = pos + size;
+
+		if (bytes_read < MSU1_AUDIO_CHUNK_SIZE)
+		{
+			if (MSU1.MSU1_STATUS & AudioRepeating)
+			{
+				// if the loop point is invalid, revert to start
+				audioReadPos = (audioLoopPos < pos + size) ? audioLoopPos : 8;
+
+				if (size == 0 && audioReadPos == pos) // nothing to loop over
+					chunk->end = audioReadEnded = TRUE;
+			}
+			else
+			{
+				chunk->end = audioReadEnded = TRUE;
+			}
+		}
+
+		if (size || chunk->end)
+			audioChunkCount++;
+	}
+
+	UnlockAudioRing();
+	return true;
+}
+
+#ifdef MSU1_AUDIO_THREAD
+static void *AudioReaderThread(void *arg)
+{
+	while (1)
+	{
+		while (AudioFillChunk())
+			usleep(100);
+		LWP_SuspendThread(audioThread);
+	}
+	return NULL;
+}
+#endif
+
+// Keeps the ring topped up - wakes the reader, or reads inline without threads
+static void AudioReadAhead()
+{
+#ifdef MSU1_AUDIO_THREAD
+	if (audioThread == LWP_THREAD_NULL)
+		LWP_CreateThread(&audioThread, AudioReaderThread, NULL, NULL, 0, MSU1_AUDIO_PRIORITY);
+	else
+		LWP_ResumeThread(audioThread);
+#else
+	while (AudioFillChunk())
+		;
+#endif
+}
+
+static void AudioSeek(uint32 pos)
+{
+	AudioFlush(pos);
+	AudioReadAhead();
+}
+
+// Copies frames stereo samples to the output, scaled by the MSU-1 volume
+static void AudioCopyFrames(const uint8 *src, int frames)
+{
+	int	samples = frames * 2;
+	int	volume = MSU1.MSU1_VOLUME;
+
+	if (volume == 0)
+	{
+		memset(bufPos, 0, samples * sizeof(int16));
+	}
+	else if (volume == 255)
+	{
+		for (int i = 0; i < samples; i++)
+			bufPos[i] = (int16)GET_LE16(src + i * 2);
+	}
+	else
+	{
+		for (int i = 0; i < samples; i++)
+			bufPos[i] = ((int32)(int16)GET_LE16(src + i * 2) * volume / 255);
+	}
+
+	bufPos += samples;
+}
+
+static void AudioSilence(int frames)
+{
+	memset(bufPos, 0, frames * 2 * sizeof(int16));
+	bufPos += frames * 2;
+	partial_frames -= 3204 * frames;
+}
+
+static void AudioStop()
+{
+	MSU1.MSU1_STATUS &= ~(AudioPlaying | AudioRepeating);
+	MSU1.MSU1_AUDIO_POS = 8;
+	AudioSeek(8);
+}
+
 #ifdef UNZIP_SUPPORT
 static int unzFindExtension(unzFile &file, const char *ext, bool restart = TRUE, bool print = TRUE, bool allowExact = FALSE)
 {
@@ -104,11 +323,15 @@ STREAM S9xMSU1OpenFile(const char *msu_ext, bool skip_unpacked)
 
 static void AudioClose()
 {
+	LockAudioStream();
 	if (audioStream)
 	{
 		CLOSE_STREAM(audioStream);
 		audioStream = NULL;
 	}
+	UnlockAudioStream();
+
+	AudioFlush(8);
 }
 
 static bool AudioOpen()
@@ -120,29 +343,35 @@ static bool AudioOpen()
 	char ext[_MAX_EXT];
 	snprintf(ext, _MAX_EXT, "-%d.pcm", MSU1.MSU1_CURRENT_TRACK);
 
+	LockAudioStream();
+
     audioStream = S9xMSU1OpenFile(ext);
 	if (audioStream)
 	{
-		if (GETC_STREAM(audioStream) != 'M')
-			return false;
-		if (GETC_STREAM(audioStream) != 'S')
-			return false;
-		if (GETC_STREAM(audioStream) != 'U')
-			return false;
-		if (GETC_STREAM(audioStream) != '1')
+		if (GETC_STREAM(audioStream) != 'M' ||
+			GETC_STREAM(audioStream) != 'S' ||
+			GETC_STREAM(audioStream) != 'U' ||
+			GETC_STREAM(audioStream) != '1')
+		{
+			UnlockAudioStream();
 			return false;
+		}
 
         READ_STREAM((char *)&audioLoopPos, 4, audioStream);
 		audioLoopPos = GET_LE32(&audioLoopPos);
 		audioLoopPos <<= 2;
 		audioLoopPos += 8;
 
+		audioStreamPos = 8;
+		UnlockAudioStream();
+
         MSU1.MSU1_AUDIO_POS = 8;
 
 		MSU1.MSU1_STATUS &= ~AudioError;
 		return true;
 	}
 
+	UnlockAudioStream();
 	return false;
 }
 
@@ -237,60 +466,78 @@ void S9xMSU1Generate(size_t sample_count)
 {
 	partial_frames += 4410 * (sample_count / 2);
 
-	while ((bufPos < (bufEnd - 2)) && partial_frames >= 3204)
+	int room = bufEnd - 2 - bufPos;
+	int frames = (room > 0) ? (room + 1) / 2 : 0;
+
+	if ((int)(partial_frames / 3204) < frames)
+		frames = partial_frames / 3204;
+
+	while (frames > 0)
 	{
-		if (MSU1.MSU1_STATUS & AudioPlaying && audioStream)
+		if (!(MSU1.MSU1_STATUS & AudioPlaying && audioStream))
 		{
-			int32 sample;
-			int16* left = (int16*)&sample;
-			int16* right = left + 1;
+			MSU1.MSU1_STATUS &= ~(AudioPlaying | AudioRepeating);
+			AudioSilence(frames);
+			break;
+		}
 
-			int bytes_read = READ_STREAM((char *)&sample, 4, audioStream);
-			if (bytes_read == 4)
-			{
-				*left = ((int32)(int16)GET_LE16(left) * MSU1.MSU1_VOLUME / 255);
-				*right = ((int32)(int16)GET_LE16(right) * MSU1.MSU1_VOLUME / 255);
+		LockAudioRing();
 
+		if (audioChunkCount == 0)
+		{
+			// the reader is behind - play silence rather than wait for the file
+			UnlockAudioRing();
+			AudioSilence(frames);
+			break;
+		}
 
-				*(bufPos++) = *left;
-				*(bufPos++) = *right;
-				MSU1.MSU1_AUDIO_POS += 4;
-				partial_frames -= 3204;
-			}
-			else
-			if (bytes_read >= 0)
+		MSU1AudioChunk *chunk = &audioChunks[audioChunkHead];
+
+		if (audioChunkOffset == 0 && chunk->pos != MSU1.MSU1_AUDIO_POS && !(MSU1.MSU1_STATUS & AudioRepeating))
+		{
+			// the reader looped, but the game has turned repeat off since
+			UnlockAudioRing();
+			AudioStop();
+			continue;
+		}
+
+		int available = (chunk->size - audioChunkOffset) >> 2;
+
+		if (available == 0)
+		{
+			bool8 end = chunk->end;
+
+			audioChunkHead = (audioChunkHead + 1) % MSU1_AUDIO_CHUNKS;
+			audioChunkCount--;
+			audioChunkOffset = 0;
+			UnlockAudioRing();
+
+			if (end)
 			{
-				if (MSU1.MSU1_STATUS & AudioRepeating)
+				if (MSU1.MSU1_STATUS & AudioRepeating) // repeat was turned on after the reader got here
 				{
-					if (audioLoopPos < MSU1.MSU1_AUDIO_POS)
-					{
-						MSU1.MSU1_AUDIO_POS = audioLoopPos;
-					}
-					else // if the loop point is invalid, revert to start
-					{
-						MSU1.MSU1_AUDIO_POS = 8;
-					}
-					REVERT_STREAM(audioStream, MSU1.MSU1_AUDIO_POS, 0);
+					MSU1.MSU1_AUDIO_POS = (audioLoopPos < MSU1.MSU1_AUDIO_POS) ? audioLoopPos : 8;
+					AudioSeek(MSU1.MSU1_AUDIO_POS);
 				}
 				else
-				{
-					MSU1.MSU1_STATUS &= ~(AudioPlaying | AudioRepeating);
-					REVERT_STREAM(audioStream, 8, 0);
-				}
-			}
-			else
-			{
-				MSU1.MSU1_STATUS &= ~(AudioPlaying | AudioRepeating);
+					AudioStop();
 			}
+			continue;
 		}
-		else
-		{
-			MSU1.MSU1_STATUS &= ~(AudioPlaying | AudioRepeating);
-			partial_frames -= 3204;
-			*(bufPos++) = 0;
-			*(bufPos++) = 0;
-		}
+
+		if (available > frames)
+			available = frames;
+
+		AudioCopyFrames(chunk->data + audioChunkOffset, available);
+		audioChunkOffset += available << 2;
+		MSU1.MSU1_AUDIO_POS = chunk->pos + audioChunkOffset;
+		partial_frames -= 3204 * available;
+		frames -= available;
+
+		UnlockAudioRing();
 	}
+
+	AudioReadAhead();
 }
 
 
@@ -382,7 +629,7 @@ void S9xMSU1WritePort(uint8 port, uint8 byte)
 				MSU1.MSU1_AUDIO_POS = 8;
 			}
 
-            REVERT_STREAM(audioStream, MSU1.MSU1_AUDIO_POS, 0);
+			AudioSeek(MSU1.MSU1_AUDIO_POS);
 		}
 		break;
 	case 6:
@@ -427,14 +674,9 @@ void S9xMSU1PostLoadState(void)
 
 		if (AudioOpen())
 		{
-            REVERT_STREAM(audioStream, 4, 0);
-            READ_STREAM((char *)&audioLoopPos, 4, audioStream);
-			audioLoopPos = GET_LE32(&audioLoopPos);
-			audioLoopPos <<= 2;
-			audioLoopPos += 8;
-
+			// AudioOpen has read the loop point already
 			MSU1.MSU1_AUDIO_POS = savedPosition;
-            REVERT_STREAM(audioStream, MSU1.MSU1_AUDIO_POS, 0);
+			AudioSeek(MSU1.MSU1_AUDIO_POS);
 		}
 		else
 		{
@@ -1739,7 +1739,7 @@ void S9xResetPPUFast (void)
 {
 	PPU.RecomputeClipWindows = TRUE;
 	IPPU.ColorsChanged = TRUE;
-	IPPU.OBJChanged = TRUE;
+	S9xMarkOBJDirty(0, 127);
 	memset(IPPU.TileCached[TILE_2BIT], 0, MAX_2BIT_TILES);
 	memset(IPPU.TileCached[TILE_4BIT], 0, MAX_4BIT_TILES);
 	memset(IPPU.TileCached[TILE_8BIT], 0, MAX_8BIT_TILES);
@@ -1884,8 +1884,9 @@ void S9xSoftResetPPU (void)
 
 	for (int c = 0; c < 2; c++)
 		memset(&IPPU.Clip[c], 0, sizeof(struct ClipData));
+	S9xResetClipWindowCache();
 	IPPU.ColorsChanged = TRUE;
-	IPPU.OBJChanged = TRUE;
+	S9xMarkOBJDirty(0, 127);
 	memset(IPPU.TileCached[TILE_2BIT], 0, MAX_2BIT_TILES);
 	memset(IPPU.TileCached[TILE_4BIT], 0, MAX_4BIT_TILES);
 	memset(IPPU.TileCached[TILE_8BIT], 0, MAX_8BIT_TILES);
@@ -1928,4 +1929,7 @@ void S9xSoftResetPPU (void)
 
 	Memory.FillRAM[0x4201] = Memory.FillRAM[0x4213] = 0xff;
 	Memory.FillRAM[0x2126] = Memory.FillRAM[0x2128] = 1;
+
+	// CGRAM, OAM and the registers have changed (and VRAM too on S9xReset)
+	S9xInvalidateScreenRows(0, MAX_SNES_HEIGHT - 1);
 }
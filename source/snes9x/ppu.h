@@ -39,6 +39,9 @@ struct InternalPPU
 	struct ClipData Clip[2][6];
 	bool8	ColorsChanged;
 	bool8	OBJChanged;
+	int		OBJDirtyFirst;	// range of sprites changed since the last SetupOBJ
+	int		OBJDirtyLast;
+	uint32	ScreenGeneration;	// bumped whenever VRAM, CGRAM or OAM contents change
 	uint8	*TileCache[7];
 	uint8	*TileCached[7];
 	bool8	Interlace;
@@ -235,6 +238,25 @@ static inline void FLUSH_REDRAW (void)
 		S9xUpdateScreen();
 }
 
+static inline void S9xMarkOBJDirty (int first, int last)
+{
+	if (first < IPPU.OBJDirtyFirst)
+		IPPU.OBJDirtyFirst = first;
+	if (last > IPPU.OBJDirtyLast)
+		IPPU.OBJDirtyLast = last;
+	IPPU.OBJChanged = TRUE;
+	IPPU.ScreenGeneration++;
+}
+
+static inline void S9xWriteVRAM (uint32 address, uint8 Byte)
+{
+	if (Memory.VRAM[address] != Byte)
+	{
+		Memory.VRAM[address] = Byte;
+		IPPU.ScreenGeneration++;
+	}
+}
+
 static inline void S9xUpdateVRAMReadBuffer()
 {
 	if (PPU.VMA.FullGraphicCount)
@@ -263,7 +285,7 @@ static inline void REGISTER_2104 (uint8 Byte)
 		{
 			FLUSH_REDRAW();
 			PPU.OAMData[addr] = Byte;
-			IPPU.OBJChanged = TRUE;
+			S9xMarkOBJDirty((addr & 0x1f) * 4, (addr & 0x1f) * 4 + 3);
 
 			// X position high bit, and sprite size (x4)
 			struct SOBJ *pObj = &PPU.OBJ[(addr & 0x1f) * 4];
@@ -291,7 +313,7 @@ static inline void REGISTER_2104 (uint8 Byte)
 			FLUSH_REDRAW();
 			PPU.OAMData[addr] = lowbyte;
 			PPU.OAMData[addr + 1] = highbyte;
-			IPPU.OBJChanged = TRUE;
+			S9xMarkOBJDirty(PPU.OAMAddr >> 1, PPU.OAMAddr >> 1);
 			if (addr & 2)
 			{
 				// Tile
@@ -362,10 +384,10 @@ static inline void REGISTER_2118 (uint8 Byte)
 	{
 		uint32 rem = PPU.VMA.Address & PPU.VMA.Mask1;
 		address = (((PPU.VMA.Address & ~PPU.VMA.Mask1) + (rem >> PPU.VMA.Shift) + ((rem & (PPU.VMA.FullGraphicCount - 1)) << 3)) << 1) & 0xffff;
-		Memory.VRAM[address] = Byte;
+		S9xWriteVRAM(address, Byte);
 	}
 	else
-		Memory.VRAM[address = (PPU.VMA.Address << 1) & 0xffff] = Byte;
+		S9xWriteVRAM(address = (PPU.VMA.Address << 1) & 0xffff, Byte);
 
 	IPPU.TileCached[TILE_2BIT][address >> 4] = FALSE;
 	IPPU.TileCached[TILE_4BIT][address >> 5] = FALSE;
@@ -396,7 +418,7 @@ static inline void REGISTER_2118_tile (uint8 Byte)
 	uint32 rem = PPU.VMA.Address & PPU.VMA.Mask1;
 	uint32 address = (((PPU.VMA.Address & ~PPU.VMA.Mask1) + (rem >> PPU.VMA.Shift) + ((rem & (PPU.VMA.FullGraphicCount - 1)) << 3)) << 1) & 0xffff;
 
-	Memory.VRAM[address] = Byte;
+	S9xWriteVRAM(address, Byte);
 
 	IPPU.TileCached[TILE_2BIT][address >> 4] = FALSE;
 	IPPU.TileCached[TILE_4BIT][address >> 5] = FALSE;
@@ -420,7 +442,7 @@ static inline void REGISTER_2118_linear (uint8 Byte)
 
 	uint32	address;
 
-	Memory.VRAM[address = (PPU.VMA.Address << 1) & 0xffff] = Byte;
+	S9xWriteVRAM(address = (PPU.VMA.Address << 1) & 0xffff, Byte);
 
 	IPPU.TileCached[TILE_2BIT][address >> 4] = FALSE;
 	IPPU.TileCached[TILE_4BIT][address >> 5] = FALSE;
@@ -469,10 +491,10 @@ static inline void REGISTER_2119 (uint8 Byte)
 	{
 		uint32 rem = PPU.VMA.Address & PPU.VMA.Mask1;
 		address = ((((PPU.VMA.Address & ~PPU.VMA.Mask1) + (rem >> PPU.VMA.Shift) + ((rem & (PPU.VMA.FullGraphicCount - 1)) << 3)) << 1) + 1) & 0xffff;
-		Memory.VRAM[address] = Byte;
+		S9xWriteVRAM(address, Byte);
 	}
 	else
-		Memory.VRAM[address = ((PPU.VMA.Address << 1) + 1) & 0xffff] = Byte;
+		S9xWriteVRAM(address = ((PPU.VMA.Address << 1) + 1) & 0xffff, Byte);
 
 	IPPU.TileCached[TILE_2BIT][address >> 4] = FALSE;
 	IPPU.TileCached[TILE_4BIT][address >> 5] = FALSE;
@@ -503,7 +525,7 @@ static inline void REGISTER_2119_tile (uint8 Byte)
 	uint32 rem = PPU.VMA.Address & PPU.VMA.Mask1;
 	uint32 address = ((((PPU.VMA.Address & ~PPU.VMA.Mask1) + (rem >> PPU.VMA.Shift) + ((rem & (PPU.VMA.FullGraphicCount - 1)) << 3)) << 1) + 1) & 0xffff;
 
-	Memory.VRAM[address] = Byte;
+	S9xWriteVRAM(address, Byte);
 
 	IPPU.TileCached[TILE_2BIT][address >> 4] = FALSE;
 	IPPU.TileCached[TILE_4BIT][address >> 5] = FALSE;
@@ -527,7 +549,7 @@ static inline void REGISTER_2119_linear (uint8 Byte)
 
 	uint32	address;
 
-	Memory.VRAM[address = ((PPU.VMA.Address << 1) + 1) & 0xffff] = Byte;
+	S9xWriteVRAM(address = ((PPU.VMA.Address << 1) + 1) & 0xffff, Byte);
 
 	IPPU.TileCached[TILE_2BIT][address >> 4] = FALSE;
 	IPPU.TileCached[TILE_4BIT][address >> 5] = FALSE;
@@ -558,6 +580,7 @@ static inline void REGISTER_2122 (uint8 Byte)
 			IPPU.Blue[PPU.CGADD] = IPPU.XB[(Byte >> 2) & 0x1f];
 			IPPU.Green[PPU.CGADD] = IPPU.XB[(PPU.CGDATA[PPU.CGADD] >> 5) & 0x1f];
 			IPPU.ScreenColors[PPU.CGADD] = (uint16) BUILD_PIXEL(IPPU.Red[PPU.CGADD], IPPU.Green[PPU.CGADD], IPPU.Blue[PPU.CGADD]);
+			IPPU.ScreenGeneration++;
 		}
 
 		PPU.CGADD++;
@@ -7,7 +7,46 @@
 #include "snes9x.h"
 #include "memmap.h"
 #include "sdd1.h"
+#include "sdd1emu.h"
 #include "display.h"
+#ifdef HW_RVL
+	#include <gccore.h>
+	#include "../mem2.h"
+	#define SDD1_CACHE_ALLOC(size)	(uint8 *) mem2_malloc(size)
+	#define SDD1_CACHE_FREE(p)		mem2_free(p)
+#elif defined(USE_VM)
+	#include <gccore.h>
+	#include "vmalloc.h"
+	#define SDD1_CACHE_ALLOC(size)	(uint8 *) vm_malloc(size)
+	#define SDD1_CACHE_FREE(p)		vm_free(p)
+#else
+	#define SDD1_CACHE_ALLOC(size)	(uint8 *) malloc(size)
+	#define SDD1_CACHE_FREE(p)		free(p)
+#endif
+
+// Star Ocean and Street Fighter Alpha 2 DMA the same compressed blocks over
+// and over, so decompressed outputs are kept in a ring buffer, indexed by
+// their ROM address. A shorter transfer from the same address gets a prefix
+// of the same output, so it is served from a longer entry as well.
+
+#ifdef HW_RVL
+#define SDD1_CACHE_SIZE		0x200000	// in MEM2
+#else
+#define SDD1_CACHE_SIZE		0x100000	// ARAM backed on the GameCube
+#endif
+#define SDD1_CACHE_INDEX_BITS	11
+#define SDD1_CACHE_ENTRIES	(1 << SDD1_CACHE_INDEX_BITS)
+
+struct SSDD1CacheEntry
+{
+	uint32	address;
+	uint32	length;
+	uint64	start;		// where it was written, counted in SDD1CacheWritten
+};
+
+static uint8			*SDD1Cache = NULL;
+static uint64			SDD1CacheWritten = 0;	// bytes ever written, 64-bit so it never wraps
+static SSDD1CacheEntry	SDD1CacheIndex[SDD1_CACHE_ENTRIES];
 
 
 void S9xSetSDD1MemoryMap (uint32 bank, uint32 value)
@@ -25,6 +64,9 @@ void S9xSetSDD1MemoryMap (uint32 bank, uint32 value)
 
 void S9xResetSDD1 (void)
 {
+	// the cached outputs may belong to a different ROM
+	memset(SDD1CacheIndex, 0, sizeof(SDD1CacheIndex));
+
 	memset(&Memory.FillRAM[0x4800], 0, 4);
 	for (int i = 0; i < 4; i++)
 	{
@@ -33,8 +75,67 @@ void S9xResetSDD1 (void)
 	}
 }
 
+void S9xDeinitSDD1 (void)
+{
+	if (!SDD1Cache)
+		return;
+
+	SDD1_CACHE_FREE(SDD1Cache);
+	SDD1Cache = NULL;
+	SDD1CacheWritten = 0;
+	memset(SDD1CacheIndex, 0, sizeof(SDD1CacheIndex));
+}
+
 void S9xSDD1PostLoadState (void)
 {
 	for (int i = 0; i < 4; i++)
 		S9xSetSDD1MemoryMap(i, Memory.FillRAM[0x4804 + i]);
 }
+
+void S9xSDD1Decompress (uint8 *out, uint8 *in, int len)
+{
+	if (len == 0)
+		len = 0x10000;
+
+	uint32	address = in - Memory.ROM;
+
+	// only ROM can't change under the cache
+	if (in < Memory.ROM || address >= Memory.CalculatedSize)
+	{
+		SDD1_decompress(out, in, len);
+		return;
+	}
+
+	if (!SDD1Cache)
+	{
+		SDD1Cache = SDD1_CACHE_ALLOC(SDD1_CACHE_SIZE);
+		if (!SDD1Cache)
+		{
+			SDD1_decompress(out, in, len);
+			return;
+		}
+	}
+
+	SSDD1CacheEntry	*entry = &SDD1CacheIndex[(address * 2654435761U) >> (32 - SDD1_CACHE_INDEX_BITS)];
+
+	// an entry is gone once the ring has come all the way around to it
+	if (entry->address == address && entry->length >= (uint32) len &&
+		SDD1CacheWritten - entry->start <= SDD1_CACHE_SIZE)
+	{
+		memcpy(out, SDD1Cache + (entry->start & (SDD1_CACHE_SIZE - 1)), len);
+		return;
+	}
+
+	SDD1_decompress(out, in, len);
+
+	// entries never wrap, skip to the start of the ring instead
+	uint32	pos = (uint32) (SDD1CacheWritten & (SDD1_CACHE_SIZE - 1));
+	if (pos + len > SDD1_CACHE_SIZE)
+		SDD1CacheWritten += SDD1_CACHE_SIZE - pos;
+
+	entry->address = address;
+	entry->length = len;
+	entry->start = SDD1CacheWritten;
+	memcpy(SDD1Cache + (SDD1CacheWritten & (SDD1_CACHE_SIZE - 1)), out, len);
+	SDD1CacheWritten += len;
+}
@@ -16,6 +16,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include "sha256.h"
 
 /****************************** MACROS ******************************/
 #define ROTLEFT(a,b) (((a) << (b)) | ((a) >> (32-(b))))
@@ -33,13 +34,6 @@
 typedef unsigned char BYTE;             /* 8-bit byte */
 typedef unsigned int  WORD;             /* 32-bit word, change to "long" for 16-bit machines */
 
-typedef struct {
-	BYTE data[64];
-	WORD datalen;
-	uint64_t bitlen;
-	WORD state[8];
-} SHA256_CTX;
-
 /**************************** VARIABLES *****************************/
 static const WORD k[64] = {
 	0x428a2f98,0x71374491,0xb5c0fbcf,0xe9b5dba5,0x3956c25b,0x59f111f1,0x923f82a4,0xab1c5ed5,
@@ -53,14 +47,46 @@ static const WORD k[64] = {
 };
 
 /*********************** FUNCTION DEFINITIONS ***********************/
-void sha256_transform(SHA256_CTX *ctx, const BYTE data[])
+/* SHA-256 words are big endian, so on a big endian host (the Gekko) the
+   message words are loaded as they are instead of a byte at a time. */
+static inline WORD load_be32(const BYTE *p)
 {
-	WORD a, b, c, d, e, f, g, h, i, j, t1, t2, m[64];
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	WORD w;
+	memcpy(&w, p, 4);
+	return w;
+#else
+	return ((WORD)p[0] << 24) | ((WORD)p[1] << 16) | ((WORD)p[2] << 8) | (WORD)p[3];
+#endif
+}
 
-	for (i = 0, j = 0; i < 16; ++i, j += 4)
-		m[i] = (data[j] << 24) | (data[j + 1] << 16) | (data[j + 2] << 8) | (data[j + 3]);
-	for ( ; i < 64; ++i)
-		m[i] = SIG1(m[i - 2]) + m[i - 7] + SIG0(m[i - 15]) + m[i - 16];
+/* The schedule only ever looks 16 words back, so it is kept in a rolling
+   window instead of expanding all 64 words up front. */
+#define SCHEDULE(i) \
+	(m[(i) & 15] += SIG1(m[((i) - 2) & 15]) + m[((i) - 7) & 15] + SIG0(m[((i) - 15) & 15]))
+
+/* One round, with the working variables renamed by the caller rather than
+   shifted: only d and h change. */
+#define ROUND(a,b,c,d,e,f,g,h,i,w) \
+	t1 = h + EP1(e) + CH(e,f,g) + k[i] + (w); \
+	d += t1; \
+	h = t1 + EP0(a) + MAJ(a,b,c)
+
+#define ROUNDS8(i,W) \
+	ROUND(a,b,c,d,e,f,g,h,(i) + 0,W((i) + 0)); \
+	ROUND(h,a,b,c,d,e,f,g,(i) + 1,W((i) + 1)); \
+	ROUND(g,h,a,b,c,d,e,f,(i) + 2,W((i) + 2)); \
+	ROUND(f,g,h,a,b,c,d,e,(i) + 3,W((i) + 3)); \
+	ROUND(e,f,g,h,a,b,c,d,(i) + 4,W((i) + 4)); \
+	ROUND(d,e,f,g,h,a,b,c,(i) + 5,W((i) + 5)); \
+	ROUND(c,d,e,f,g,h,a,b,(i) + 6,W((i) + 6)); \
+	ROUND(b,c,d,e,f,g,h,a,(i) + 7,W((i) + 7))
+
+#define LOAD(i) (m[i] = load_be32(data + (i) * 4))
+
+static void sha256_transform(SHA256_CTX *ctx, const BYTE data[])
+{
+	WORD a, b, c, d, e, f, g, h, t1, m[16];
 
 	a = ctx->state[0];
 	b = ctx->state[1];
@@ -71,18 +97,14 @@ void sha256_transform(SHA256_CTX *ctx, const BYTE data[])
 	g = ctx->state[6];
 	h = ctx->state[7];
 
-	for (i = 0; i < 64; ++i) {
-		t1 = h + EP1(e) + CH(e,f,g) + k[i] + m[i];
-		t2 = EP0(a) + MAJ(a,b,c);
-		h = g;
-		g = f;
-		f = e;
-		e = d + t1;
-		d = c;
-		c = b;
-		b = a;
-		a = t1 + t2;
-	}
+	ROUNDS8(0, LOAD);
+	ROUNDS8(8, LOAD);
+	ROUNDS8(16, SCHEDULE);
+	ROUNDS8(24, SCHEDULE);
+	ROUNDS8(32, SCHEDULE);
+	ROUNDS8(40, SCHEDULE);
+	ROUNDS8(48, SCHEDULE);
+	ROUNDS8(56, SCHEDULE);
 
 	ctx->state[0] += a;
 	ctx->state[1] += b;
@@ -110,17 +132,30 @@ void sha256_init(SHA256_CTX *ctx)
 
 void sha256_update(SHA256_CTX *ctx, const BYTE data[], size_t len)
 {
-	WORD i;
+	/* Top up a partially filled block first */
+	if (ctx->datalen) {
+		size_t n = 64 - ctx->datalen;
+		if (n > len)
+			n = len;
+		memcpy(ctx->data + ctx->datalen, data, n);
+		ctx->datalen += n;
+		data += n;
+		len -= n;
+		if (ctx->datalen < 64)
+			return;
+		sha256_transform(ctx, ctx->data);
+		ctx->bitlen += 512;
+		ctx->datalen = 0;
+	}
 
-	for (i = 0; i < len; ++i) {
-		ctx->data[ctx->datalen] = data[i];
-		ctx->datalen++;
-		if (ctx->datalen == 64) {
-			sha256_transform(ctx, ctx->data);
-			ctx->bitlen += 512;
-			ctx->datalen = 0;
-		}
+	/* Whole blocks are hashed straight from the input */
+	for ( ; len >= 64; data += 64, len -= 64) {
+		sha256_transform(ctx, data);
+		ctx->bitlen += 512;
 	}
+
+	memcpy(ctx->data, data, len);
+	ctx->datalen = len;
 }
 
 void sha256_final(SHA256_CTX *ctx, BYTE hash[])
@@ -1001,6 +1001,7 @@ static void FreezeBlock (STREAM, const char *, uint8 *, int);
 static void FreezeStruct (STREAM, const char *, void *, FreezeData *, int);
 static bool CheckBlockName(STREAM stream, const char *name, int &len);
 static void SkipBlockWithName(STREAM stream, const char *name);
+static int FreezeSRAMSize (void);
 
 
 void S9xResetSaveTimer (bool8 dontsave)
@@ -1195,7 +1196,9 @@ void S9xFreezeToStream (STREAM stream)
 
 	FreezeBlock (stream, "RAM", Memory.RAM, 0x20000);
 
-	FreezeBlock (stream, "SRA", Memory.SRAM, 0x80000);
+	int	sram_size = FreezeSRAMSize();
+	if (sram_size)
+		FreezeBlock (stream, "SRA", Memory.SRAM, sram_size);
 
 	FreezeBlock (stream, "FIL", Memory.FillRAM, 0x8000);
 
@@ -1403,7 +1406,7 @@ int S9xUnfreezeFromStream (STREAM stream)
 			result = UnfreezeBlock(stream, "SRA", Memory.SRAM, 0x80000);
 		else
 			result = UnfreezeBlockCopy (stream, "SRA", &local_sram, 0x80000);
-		if (result != SUCCESS)
+		if (result != SUCCESS && version < SNAPSHOT_VERSION_COMPACT) // carts without SRAM have no block since v12
 			break;
 
 		if (fast)
@@ -1685,7 +1688,7 @@ int S9xUnfreezeFromStream (STREAM stream)
 		S9xFixColourBrightness();
 		S9xBuildDirectColourMaps();
 		IPPU.ColorsChanged = TRUE;
-		IPPU.OBJChanged = TRUE;
+		S9xMarkOBJDirty(0, 127);
 		IPPU.RenderThisFrame = TRUE;
 		
 		GFX.InterlaceFrame = Timings.InterlaceField;
@@ -1695,6 +1698,7 @@ int S9xUnfreezeFromStream (STREAM stream)
 		
 		if (Settings.FastSavestates == 0)
 			memset(GFX.Screen,0,GFX.Pitch * MAX_SNES_HEIGHT);
+		S9xInvalidateScreenRows(0, MAX_SNES_HEIGHT - 1);
 
 		// TODO: this seems to be a relic from 1.43 changes, completely remove if no issues in the future
 		/*uint8 hdma_byte = Memory.FillRAM[0x420c];
@@ -1949,7 +1953,9 @@ static void FreezeStruct (STREAM stream, const char *name, void *base, FreezeDat
 			len += FreezeSize(fields[i].size, fields[i].type);
 	}
 
-	uint8	*block = new uint8[len];
+	// most structs are small enough to pack on the stack
+	uint8	local_block[4096];
+	uint8	*block = (len <= (int) sizeof(local_block)) ? local_block : new uint8[len];
 	uint8	*ptr = block;
 	uint8	*addr;
 	uint16	word;
@@ -2051,7 +2057,17 @@ static void FreezeStruct (STREAM stream, const char *name, void *base, FreezeDat
 	}
 
 	FreezeBlock(stream, name, block, len);
-	delete [] block;
+	if (block != local_block)
+		delete [] block;
+}
+
+static int FreezeSRAMSize (void)
+{
+	// these use Memory.SRAM as work RAM beyond the size in the header
+	if (Settings.SA1 || Settings.SuperFX || Settings.BS || Settings.SETA || Multi.cartType)
+		return (0x80000);
+
+	return (Memory.SRAMSize ? min(Memory.SRAMMask + 1, (uint32) 0x80000) : 0);
 }
 
 static void FreezeBlock (STREAM stream, const char *name, uint8 *block, int size)
@@ -13,7 +13,8 @@
 #define SNAPSHOT_VERSION_IRQ		7
 #define SNAPSHOT_VERSION_BAPU		8
 #define SNAPSHOT_VERSION_IRQ_2018	11		// irq changes were introduced earlier, since this we store NextIRQTimer directly
-#define SNAPSHOT_VERSION			11
+#define SNAPSHOT_VERSION_COMPACT	12		// SRAM is only stored up to the size the cartridge uses
+#define SNAPSHOT_VERSION			12
 
 #define SUCCESS					1
 #define WRONG_FORMAT			(-1)
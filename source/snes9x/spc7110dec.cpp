@@ -19,6 +19,17 @@
 #ifdef _SPC7110EMU_CPP_
 
 uint8 SPC7110Decomp::read() {
+  if(!stream) return decode();
+  if(stream_pos < stream->length) return stream->data[stream_pos++];
+
+  if(decoder_pos != stream_pos) seek_decoder();
+  uint8 data = decode();
+  cache_byte(decoder_pos++, data);
+  stream_pos++;
+  return data;
+}
+
+uint8 SPC7110Decomp::decode() {
   if(decomp_buffer_length == 0) {
     //decompress at least (decomp_buffer_size / 2) bytes to the buffer
     switch(decomp_mode) {
@@ -48,6 +59,22 @@ uint8 SPC7110Decomp::dataread() {
 }
 
 void SPC7110Decomp::init(unsigned mode, unsigned offset, unsigned index) {
+  if(mode > 2) {
+    //invalid mode, always reads 0x00
+    stream = NULL;
+    start(mode, offset);
+    return;
+  }
+
+  //the decoder is started lazily, once a read goes past the cached data
+  decomp_mode = mode;
+  decomp_offset = offset;
+  stream = find_stream(mode, offset);
+  stream_pos = index;
+  decoder_pos = ~0U;
+}
+
+void SPC7110Decomp::start(unsigned mode, unsigned offset) {
   decomp_mode = mode;
   decomp_offset = offset;
 
@@ -66,9 +93,72 @@ void SPC7110Decomp::init(unsigned mode, unsigned offset, unsigned index) {
     case 1: mode1(true); break;
     case 2: mode2(true); break;
   }
+}
+
+void SPC7110Decomp::seek_decoder() {
+  //restart the decoder if it is past the read position or was never started
+  if(decoder_pos > stream_pos) {
+    start(stream->mode, stream->offset);
+    decoder_pos = 0;
+  }
 
-  //decompress up to requested output data index
-  while(index--) read();
+  //decompress up to the read position, keeping anything not cached yet
+  while(decoder_pos < stream_pos) {
+    uint8 data = decode();
+    cache_byte(decoder_pos++, data);
+  }
+}
+
+void SPC7110Decomp::cache_byte(unsigned pos, uint8 data) {
+  if(pos != stream->length || stream->length >= cache_stream_max) return;
+
+  if(stream->length == stream->capacity) {
+    unsigned capacity = stream->capacity ? stream->capacity << 1 : 0x1000;
+    uint8 *grown = (uint8*)realloc(stream->data, capacity);
+    if(!grown) return;
+    stream->data = grown;
+    stream->capacity = capacity;
+  }
+
+  stream->data[stream->length++] = data;
+}
+
+void SPC7110Decomp::sync_decoder() {
+  if(stream && decoder_pos != stream_pos) seek_decoder();
+}
+
+void SPC7110Decomp::detach_cache() {
+  stream = NULL;
+}
+
+SPC7110Decomp::CacheStream *SPC7110Decomp::find_stream(unsigned mode, unsigned offset) {
+  CacheStream *lru = &cache[0];
+
+  for(unsigned i = 0; i < cache_streams; i++) {
+    CacheStream *s = &cache[i];
+    if(s->mode == mode && s->offset == offset) {
+      s->last_used = ++cache_clock;
+      return s;
+    }
+    if(s->last_used < lru->last_used) lru = s;
+  }
+
+  //reuse the least recently used stream and its buffer
+  lru->mode = mode;
+  lru->offset = offset;
+  lru->length = 0;
+  lru->last_used = ++cache_clock;
+  return lru;
+}
+
+void SPC7110Decomp::flush_cache() {
+  for(unsigned i = 0; i < cache_streams; i++) {
+    cache[i].length = 0;
+    cache[i].last_used = 0;
+    cache[i].mode = ~0U;
+  }
+  cache_clock = 0;
+  stream = NULL;
 }
 
 //
@@ -495,10 +585,17 @@ void SPC7110Decomp::reset() {
   decomp_buffer_rdoffset = 0;
   decomp_buffer_wroffset = 0;
   decomp_buffer_length   = 0;
+
+  //the cached streams may belong to a different ROM
+  flush_cache();
 }
 
 SPC7110Decomp::SPC7110Decomp() {
   decomp_buffer = new uint8[decomp_buffer_size];
+  for(unsigned i = 0; i < cache_streams; i++) {
+    cache[i].data = NULL;
+    cache[i].capacity = 0;
+  }
   reset();
 
   //initialize reverse morton lookup tables
@@ -524,6 +621,7 @@ SPC7110Decomp::SPC7110Decomp() {
 
 SPC7110Decomp::~SPC7110Decomp() {
   delete[] decomp_buffer;
+  for(unsigned i = 0; i < cache_streams; i++) free(cache[i].data);
 }
 
 #endif
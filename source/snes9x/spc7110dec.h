@@ -25,6 +25,11 @@ public:
   void init(unsigned mode, unsigned offset, unsigned index);
   void reset();
 
+  //bring the decoder state up to date with reads served from the cache
+  void sync_decoder();
+  //read straight from the decoder, e.g. after its state has been restored
+  void detach_cache();
+
   SPC7110Decomp();
   ~SPC7110Decomp();
 
@@ -41,6 +46,31 @@ public:
   void write(uint8 data);
   uint8 dataread();
 
+  void start(unsigned mode, unsigned offset);
+  uint8 decode();
+
+  //games request the same compressed packs over and over, so the output of
+  //each stream is kept, keyed by (mode, offset), and repeat reads are served
+  //from it. the decoder only runs past the end of what has been seen before.
+  enum { cache_streams = 16, cache_stream_max = 0x8000 };
+  struct CacheStream {
+    unsigned mode;
+    unsigned offset;
+    uint8 *data;
+    unsigned length;
+    unsigned capacity;
+    unsigned last_used;
+  } cache[cache_streams];
+  CacheStream *stream;   //stream being read, or NULL to read from the decoder
+  unsigned stream_pos;   //position of the next read in stream
+  unsigned decoder_pos;  //bytes the decoder has produced for stream, ~0 if not started
+  unsigned cache_clock;
+
+  CacheStream *find_stream(unsigned mode, unsigned offset);
+  void seek_decoder();
+  void cache_byte(unsigned pos, uint8 data);
+  void flush_cache();
+
   void mode0(bool init);
   void mode1(bool init);
   void mode2(bool init);
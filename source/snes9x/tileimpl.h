@@ -508,6 +508,60 @@ namespace TileImpl {
 
 	#define DRAW_PIXEL(N, M) PIXEL::Draw(N, M, Offset, OffsetInLine, Pix, OP::Z1(D, b), OP::Z2(D, b))
 
+	// Fetches Count pixels of a Mode 7 line into Line, starting at the 8.8 fixed point position (X, Y) and
+	// stepping by (DX, DY). Split by REPEAT (Mode7Repeat 0, 2 or 3) so the inner loop doesn't branch on it,
+	// and unrolled four pixels at a time with independent positions to keep the pipeline busy.
+	// Pixels outside the 1024x1024 map with REPEAT 2 are fetched as 0, which is never drawn.
+
+	template<int REPEAT>
+	static inline uint8 FetchMode7Pixel(const uint8 *VRAM1, int X, int Y)
+	{
+		X >>= 8;
+		Y >>= 8;
+
+		if (REPEAT == 0)
+		{
+			X &= 0x3ff;
+			Y &= 0x3ff;
+		}
+		else
+		if ((X | Y) & ~0x3ff)
+			return (REPEAT == 3 ? *(VRAM1 + ((Y & 7) << 4) + ((X & 7) << 1)) : 0);
+
+		const uint8	*TileData = VRAM1 + (Memory.VRAM[((Y & ~7) << 5) + ((X >> 2) & ~1)] << 7);
+		return (*(TileData + ((Y & 7) << 4) + ((X & 7) << 1)));
+	}
+
+	template<int REPEAT>
+	static void FetchMode7Line(uint8 *Line, int Count, int X, int Y, int DX, int DY)
+	{
+		const uint8	*VRAM1 = Memory.VRAM + 1;
+		int			i = 0;
+
+		for (; i + 4 <= Count; i += 4, X += DX * 4, Y += DY * 4)
+		{
+			Line[i + 0] = FetchMode7Pixel<REPEAT>(VRAM1, X, Y);
+			Line[i + 1] = FetchMode7Pixel<REPEAT>(VRAM1, X + DX, Y + DY);
+			Line[i + 2] = FetchMode7Pixel<REPEAT>(VRAM1, X + DX * 2, Y + DY * 2);
+			Line[i + 3] = FetchMode7Pixel<REPEAT>(VRAM1, X + DX * 3, Y + DY * 3);
+		}
+
+		for (; i < Count; i++, X += DX, Y += DY)
+			Line[i] = FetchMode7Pixel<REPEAT>(VRAM1, X, Y);
+	}
+
+	typedef void (*FetchMode7Line_t)(uint8 *Line, int Count, int X, int Y, int DX, int DY);
+
+	static inline FetchMode7Line_t GetFetchMode7Line()
+	{
+		switch (PPU.Mode7Repeat)
+		{
+			case 0:  return (FetchMode7Line<0>);
+			case 3:  return (FetchMode7Line<3>);
+			default: return (FetchMode7Line<2>);
+		}
+	}
+
 	struct DrawMode7BG1_OP
 	{
 		enum {
@@ -536,7 +590,8 @@ namespace TileImpl {
 
 		static void Draw(uint32 Left, uint32 Right, int D)
 		{
-			uint8	*VRAM1 = Memory.VRAM + 1;
+			FetchMode7Line_t	FetchLine = GetFetchMode7Line();
+			uint8				LineBuf[SNES_WIDTH];
 
 			if (OP::DCMODE())
 			{
@@ -593,41 +648,13 @@ namespace TileImpl {
 
 				uint8	Pix;
 
-				if (!PPU.Mode7Repeat)
-				{
-					for (uint32 x = Left; x < Right; x++, AA += aa, CC += cc)
-					{
-						int	X = ((AA + BB) >> 8) & 0x3ff;
-						int	Y = ((CC + DD) >> 8) & 0x3ff;
-
-						uint8	*TileData = VRAM1 + (Memory.VRAM[((Y & ~7) << 5) + ((X >> 2) & ~1)] << 7);
-						uint8	b = *(TileData + ((Y & 7) << 4) + ((X & 7) << 1));
+				FetchLine(LineBuf, Right - Left, AA + BB, CC + DD, aa, cc);
 
-						Pix = b & OP::MASK; DRAW_PIXEL(x, Pix);
-					}
-				}
-				else
+				for (uint32 x = Left; x < Right; x++)
 				{
-					for (uint32 x = Left; x < Right; x++, AA += aa, CC += cc)
-					{
-						int	X = ((AA + BB) >> 8);
-						int	Y = ((CC + DD) >> 8);
-
-						uint8	b;
-
-						if (((X | Y) & ~0x3ff) == 0)
-						{
-							uint8	*TileData = VRAM1 + (Memory.VRAM[((Y & ~7) << 5) + ((X >> 2) & ~1)] << 7);
-							b = *(TileData + ((Y & 7) << 4) + ((X & 7) << 1));
-						}
-						else
-						if (PPU.Mode7Repeat == 3)
-							b = *(VRAM1    + ((Y & 7) << 4) + ((X & 7) << 1));
-						else
-							continue;
+					uint8	b = LineBuf[x - Left];
 
-						Pix = b & OP::MASK; DRAW_PIXEL(x, Pix);
-					}
+					Pix = b & OP::MASK; DRAW_PIXEL(x, Pix);
 				}
 			}
 		}
@@ -645,7 +672,8 @@ namespace TileImpl {
 
 		static void Draw(uint32 Left, uint32 Right, int D)
 		{
-			uint8	*VRAM1 = Memory.VRAM + 1;
+			FetchMode7Line_t	FetchLine = GetFetchMode7Line();
+			uint8				LineBuf[SNES_WIDTH];
 
 			if (OP::DCMODE())
 			{
@@ -722,63 +750,20 @@ namespace TileImpl {
 				int	CC = l->MatrixC * startx + ((l->MatrixC * xx) & ~63);
 
 				uint8	Pix;
-				uint8	ctr = 1;
-
-				if (!PPU.Mode7Repeat)
-				{
-					for (int32 x = MLeft; x < MRight; x++, AA += aa, CC += cc)
-					{
-						if (--ctr)
-							continue;
-						ctr = HMosaic;
-
-						int	X = ((AA + BB) >> 8) & 0x3ff;
-						int	Y = ((CC + DD) >> 8) & 0x3ff;
 
-						uint8	*TileData = VRAM1 + (Memory.VRAM[((Y & ~7) << 5) + ((X >> 2) & ~1)] << 7);
-						uint8	b = *(TileData + ((Y & 7) << 4) + ((X & 7) << 1));
+				// Only the first pixel of each mosaic block is sampled
+				FetchLine(LineBuf, (MRight - MLeft + HMosaic - 1) / HMosaic, AA + BB, CC + DD, aa * HMosaic, cc * HMosaic);
 
-						if ((Pix = (b & OP::MASK)))
-						{
-							for (int32 h = MosaicStart; h < VMosaic; h++)
-							{
-								for (int32 w = x + HMosaic - 1; w >= x; w--)
-									DRAW_PIXEL(w + h * GFX.PPL, (w >= (int32) Left && w < (int32) Right));
-							}
-						}
-					}
-				}
-				else
+				for (int32 x = MLeft, i = 0; x < MRight; x += HMosaic, i++)
 				{
-					for (int32 x = MLeft; x < MRight; x++, AA += aa, CC += cc)
-					{
-						if (--ctr)
-							continue;
-						ctr = HMosaic;
-
-						int	X = ((AA + BB) >> 8);
-						int	Y = ((CC + DD) >> 8);
+					uint8	b = LineBuf[i];
 
-						uint8	b;
-
-						if (((X | Y) & ~0x3ff) == 0)
-						{
-							uint8	*TileData = VRAM1 + (Memory.VRAM[((Y & ~7) << 5) + ((X >> 2) & ~1)] << 7);
-							b = *(TileData + ((Y & 7) << 4) + ((X & 7) << 1));
-						}
-						else
-						if (PPU.Mode7Repeat == 3)
-							b = *(VRAM1    + ((Y & 7) << 4) + ((X & 7) << 1));
-						else
-							continue;
-
-						if ((Pix = (b & OP::MASK)))
+					if ((Pix = (b & OP::MASK)))
+					{
+						for (int32 h = MosaicStart; h < VMosaic; h++)
 						{
-							for (int32 h = MosaicStart; h < VMosaic; h++)
-							{
-								for (int32 w = x + HMosaic - 1; w >= x; w--)
-									DRAW_PIXEL(w + h * GFX.PPL, (w >= (int32) Left && w < (int32) Right));
-							}
+							for (int32 w = x + HMosaic - 1; w >= x; w--)
+								DRAW_PIXEL(w + h * GFX.PPL, (w >= (int32) Left && w < (int32) Right));
 						}
 					}
 				}
@@ -93,6 +93,29 @@ static const int interpolationTable[] = {
 	DSP_INTERPOLATION_NONE       // case 4: None
 };
 
+/****************************************************************************
+ * ApplyCoreSettings
+ *
+ * Sets the SuperFX speed and audio interpolation from GCSettings. A new
+ * SuperFX speed takes effect on the next S9xResetSuperFX.
+ ***************************************************************************/
+void ApplyCoreSettings()
+{
+	// Set SuperFX speed using lookup table
+	const int numSpeeds = sizeof(sfxSpeedTable) / sizeof(sfxSpeedTable[0]);
+	if (GCSettings.sfxOverclock >= 0 && GCSettings.sfxOverclock < numSpeeds)
+		Settings.SuperFXSpeedPerLine = sfxSpeedTable[GCSettings.sfxOverclock];
+	else
+		Settings.SuperFXSpeedPerLine = sfxSpeedTable[0];
+
+	// Set interpolation method using lookup table
+	const int numMethods = sizeof(interpolationTable) / sizeof(interpolationTable[0]);
+	if (GCSettings.Interpolation >= 0 && GCSettings.Interpolation < numMethods)
+		Settings.InterpolationMethod = interpolationTable[GCSettings.Interpolation];
+	else
+		Settings.InterpolationMethod = interpolationTable[0];
+}
+
 /****************************************************************************
  * Shutdown / Reboot / Exit
  ***************************************************************************/
@@ -383,6 +406,51 @@ extern "C" {
 	s32 __STM_Init();
 }
 
+/****************************************************************************
+ * Memory map
+ *
+ * Build with DEBUG_MEMORY to log where the large emulator buffers ended up
+ * and how much of each arena is left, over the USB Gecko
+ ***************************************************************************/
+#ifdef DEBUG_MEMORY
+static const char * MemoryArena(const void * p)
+{
+	switch((u32)p >> 28)
+	{
+		case 0x8: return "MEM1";
+		case 0x9: return "MEM2";
+		default:  return "VM";
+	}
+}
+
+static void ReportRegion(const char * name, const void * p, u32 size)
+{
+	printf("  %-14s %08x %8u  %s\n", name, (u32)p, size, p ? MemoryArena(p) : "-");
+}
+
+static void ReportMemoryMap()
+{
+	printf("Memory map:\n");
+	ReportRegion("RAM", Memory.RAM, 0x20000);
+	ReportRegion("SRAM", Memory.SRAM, 0x80000);
+	ReportRegion("VRAM", Memory.VRAM, 0x10000);
+	ReportRegion("TileCache 2bit", IPPU.TileCache[TILE_2BIT], MAX_2BIT_TILES * 64);
+	ReportRegion("TileCache 4bit", IPPU.TileCache[TILE_4BIT], MAX_4BIT_TILES * 64);
+	ReportRegion("TileCache 8bit", IPPU.TileCache[TILE_8BIT], MAX_8BIT_TILES * 64);
+	ReportRegion("ROM", Memory.FillRAM, Memory.MAX_ROM_SIZE + 0x200 + 0x8000);
+	ReportRegion("  BIOSROM", Memory.BIOSROM, 0x100000);
+	ReportRegion("  BSRAM", Memory.BSRAM, 0x80000);
+	ReportRegion("  C4RAM", Memory.C4RAM, 0x2000);
+	ReportRegion("Screen", GFX.Screen, EXT_PITCH * EXT_HEIGHT);
+	ReportRegion("savebuffer", savebuffer, SAVEBUFFERSIZE);
+
+	printf("MEM1 free: %u\n", (u32)SYS_GetArena1Hi() - (u32)SYS_GetArena1Lo());
+	#ifdef HW_RVL
+	printf("MEM2 free: %u\n", (u32)SYS_GetArena2Hi() - (u32)SYS_GetArena2Lo());
+	#endif
+}
+#endif
+
 void InitializeSnes9x() {
 	S9xUnmapAllControls ();
 	SetDefaultButtonMap ();
@@ -479,6 +547,9 @@ int main(int argc, char *argv[])
 	browserList = (BROWSERENTRY *)memalign(32,sizeof(BROWSERENTRY)*MAX_BROWSER_SIZE);
 #endif
 #endif
+	#ifdef DEBUG_MEMORY
+	ReportMemoryMap();
+	#endif
 	InitGUIThreads();
 
 	bool autoboot = false;
@@ -521,23 +592,11 @@ int main(int argc, char *argv[])
 		{
 			firstRun = false;
 			
-			// Set SuperFX speed using lookup table
-			const int numSpeeds = sizeof(sfxSpeedTable) / sizeof(sfxSpeedTable[0]);
-			if (GCSettings.sfxOverclock >= 0 && GCSettings.sfxOverclock < numSpeeds)
-				Settings.SuperFXSpeedPerLine = sfxSpeedTable[GCSettings.sfxOverclock];
-			else
-				Settings.SuperFXSpeedPerLine = sfxSpeedTable[0];
+			ApplyCoreSettings();
 
 			if (GCSettings.sfxOverclock > 0)
 			S9xResetSuperFX();
 			S9xReset();
-
-			// Set interpolation method using lookup table
-			const int numMethods = sizeof(interpolationTable) / sizeof(interpolationTable[0]);
-			if (GCSettings.Interpolation >= 0 && GCSettings.Interpolation < numMethods)
-				Settings.InterpolationMethod = interpolationTable[GCSettings.Interpolation];
-			else
-				Settings.InterpolationMethod = interpolationTable[0];
 		}
 		
 		autoboot = false;		
@@ -23,6 +23,7 @@
 #define APPVERSION 			"4.5.7"
 #define APPFOLDER 			"snes9xgx"
 #define PREF_FILE_NAME		"settings.xml"
+#define PREF_CACHE_FILE_NAME	"settings.bin"
 
 #define MAXPATHLEN 1024
 #define NOTSILENT 0
@@ -165,6 +166,7 @@ struct SGCSettings{
 	int		MapABXYRightStick;
 };
 
+void ApplyCoreSettings();
 void ExitApp();
 void ShutdownWii();
 bool SupportedIOS(u32 ios);
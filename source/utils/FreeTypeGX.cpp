@@ -27,6 +27,7 @@
 static FT_Library ftLibrary;	/**< FreeType FT_Library instance. */
 static FT_Face ftFace;			/**< FreeType reusable FT_Face typographic object. */
 static FT_GlyphSlot ftSlot;		/**< FreeType reusable FT_GlyphSlot glyph container object. */
+static FT_UInt ftFaceSize;		/**< Pixel size the FT_Face is currently set to. */
 
 FreeTypeGX *fontSystem[MAX_FONT_SIZE+1];
 
@@ -35,6 +36,7 @@ void InitFreeType(uint8_t* fontBuffer, FT_Long bufferSize)
 	FT_Init_FreeType(&ftLibrary);
 	FT_New_Memory_Face(ftLibrary, (FT_Byte *)fontBuffer, bufferSize, 0, &ftFace);
 	ftSlot = ftFace->glyph;
+	ftFaceSize = 0;
 
 	for(int i=0; i<50; i++)
 		fontSystem[i] = NULL;
@@ -49,7 +51,11 @@ void DeinitFreeType()
 
 void ChangeFontSize(FT_UInt pixelSize)
 {
+	if(pixelSize == ftFaceSize)
+		return;
+
 	FT_Set_Pixel_Sizes(ftFace, 0, pixelSize);
+	ftFaceSize = pixelSize;
 }
 
 void ClearFontData()
@@ -62,6 +68,26 @@ void ClearFontData()
 	}
 }
 
+/**
+ * Renders the given characters into the glyph atlas of a font size ahead of time.
+ *
+ * The FreeTypeGX instance for the size is created if it doesn't exist yet. Must not be called while the GUI
+ * thread is drawing.
+ *
+ * @param chars	NULL terminated string of the characters to cache.
+ * @param pixelSize	Font size to cache the characters for.
+ */
+void CacheFontData(const wchar_t* chars, FT_UInt pixelSize)
+{
+	if(pixelSize > MAX_FONT_SIZE)
+		return;
+
+	if(!fontSystem[pixelSize])
+		fontSystem[pixelSize] = new FreeTypeGX(pixelSize);
+
+	fontSystem[pixelSize]->cacheText(chars);
+}
+
 /**
  * Convert a short char string to a wide char string.
  *
@@ -102,6 +128,7 @@ FreeTypeGX::FreeTypeGX(FT_UInt pixelSize, uint8_t vertexIndex)
 	this->setCompatibilityMode(FTGX_COMPATIBILITY_DEFAULT_TEVOP_GX_PASSCLR | FTGX_COMPATIBILITY_DEFAULT_VTXDESC_GX_NONE);
 	this->ftPointSize = pixelSize;
 	this->ftKerningEnabled = FT_HAS_KERNING(ftFace);
+	this->atlasDirty = false;
 }
 
 /**
@@ -202,10 +229,9 @@ void FreeTypeGX::setDefaultMode()
  */
 void FreeTypeGX::unloadFont()
 {
-	if(this->fontData.size() == 0)
-		return;
-	for(std::map<wchar_t, ftgxCharData>::iterator i = this->fontData.begin(), iEnd = this->fontData.end(); i != iEnd; ++i)
-		free(i->second.glyphDataTexture);
+	for(size_t i = 0; i < this->atlasPages.size(); i++)
+		free(this->atlasPages[i].texture);
+	this->atlasPages.clear();
 	this->fontData.clear();
 }
 
@@ -235,6 +261,8 @@ ftgxCharData *FreeTypeGX::cacheGlyphData(wchar_t charCode)
 	FT_UInt gIndex;
 	uint16_t textureWidth = 0, textureHeight = 0;
 
+	ChangeFontSize(this->ftPointSize);
+
 	gIndex = FT_Get_Char_Index(ftFace, (FT_ULong) charCode);
 	if (gIndex != 0 && FT_Load_Glyph(ftFace, gIndex, FT_LOAD_DEFAULT | FT_LOAD_RENDER) == 0)
 	{
@@ -242,12 +270,12 @@ ftgxCharData *FreeTypeGX::cacheGlyphData(wchar_t charCode)
 		{
 			FT_Bitmap *glyphBitmap = &ftSlot->bitmap;
 
-			textureWidth = ALIGN8(glyphBitmap->width);
-			textureHeight = ALIGN8(glyphBitmap->rows);
-			if(textureWidth == 0)
-				textureWidth = 8;
-			if(textureHeight == 0)
-				textureHeight = 8;
+			// glyphs without a bitmap (spaces) take no atlas space and are never drawn
+			if(glyphBitmap->width > 0 && glyphBitmap->rows > 0)
+			{
+				textureWidth = ALIGN8(glyphBitmap->width + 2 * FTGX_ATLAS_PADDING);
+				textureHeight = ALIGN8(glyphBitmap->rows + 2 * FTGX_ATLAS_PADDING);
+			}
 
 			this->fontData[charCode].renderOffsetX = (int16_t) ftFace->glyph->bitmap_left;
 			this->fontData[charCode].glyphAdvanceX = (uint16_t) (ftFace->glyph->advance.x >> 6);
@@ -257,7 +285,15 @@ ftgxCharData *FreeTypeGX::cacheGlyphData(wchar_t charCode)
 			this->fontData[charCode].renderOffsetY = (int16_t) ftFace->glyph->bitmap_top;
 			this->fontData[charCode].renderOffsetMax = (int16_t) ftFace->glyph->bitmap_top;
 			this->fontData[charCode].renderOffsetMin = (int16_t) glyphBitmap->rows - ftFace->glyph->bitmap_top;
-			this->fontData[charCode].glyphDataTexture = NULL;
+			this->fontData[charCode].atlasPage = 0;
+			this->fontData[charCode].atlasX = 0;
+			this->fontData[charCode].atlasY = 0;
+
+			if(textureWidth > 0 && !this->allocateGlyphSpace(&this->fontData[charCode]))
+			{
+				this->fontData.erase(charCode);
+				return NULL;
+			}
 
 			this->loadGlyphData(glyphBitmap, &this->fontData[charCode]);
 
@@ -267,6 +303,22 @@ ftgxCharData *FreeTypeGX::cacheGlyphData(wchar_t charCode)
 	return NULL;
 }
 
+/**
+ * Returns the cached glyph data of a character, caching it first if needed.
+ *
+ * @param charCode	The requested glyph's character code.
+ * @return A pointer to the font structure, or NULL if the font has no glyph for the character.
+ */
+ftgxCharData *FreeTypeGX::getGlyphData(wchar_t charCode)
+{
+	std::map<wchar_t, ftgxCharData>::iterator i = this->fontData.find(charCode);
+
+	if(i != this->fontData.end())
+		return &i->second;
+
+	return this->cacheGlyphData(charCode);
+}
+
 /**
  * Locates each character in this wrapper's configured font face and proccess them.
  *
@@ -288,50 +340,110 @@ uint16_t FreeTypeGX::cacheGlyphDataComplete()
 }
 
 /**
- * Loads the rendered bitmap into the relevant structure's data buffer.
+ * Reserves space for a glyph texture in the atlas.
  *
- * This routine does a simple byte-wise copy of the glyph's rendered 8-bit grayscale bitmap into the structure's buffer.
- * Each byte is converted from the bitmap's intensity value into the a uint32_t RGBA value.
+ * The glyph is placed on the current shelf of the last atlas page. A new shelf is started when the glyph doesn't
+ * fit on the current one, and a new page is allocated when the page is full.
+ *
+ * @param charData	A pointer to the glyph's data structure, with textureWidth and textureHeight already set.
+ * @return true if space was found, false if the glyph is too large or memory ran out.
+ */
+bool FreeTypeGX::allocateGlyphSpace(ftgxCharData *charData)
+{
+	uint16_t width = charData->textureWidth;
+	uint16_t height = charData->textureHeight;
+
+	if(width > FTGX_ATLAS_SIZE || height > FTGX_ATLAS_SIZE)
+		return false;
+
+	ftgxAtlasPage *page = NULL;
+
+	if(this->atlasPages.size() > 0)
+	{
+		page = &this->atlasPages.back();
+
+		if(page->shelfX + width > FTGX_ATLAS_SIZE)
+		{
+			page->shelfX = 0;
+			page->shelfY += page->shelfHeight;
+			page->shelfHeight = 0;
+		}
+
+		if(page->shelfY + height > FTGX_ATLAS_SIZE)
+			page = NULL;
+	}
+
+	if(!page)
+	{
+		int pageSize = (FTGX_ATLAS_SIZE * FTGX_ATLAS_SIZE) >> 1;
+		ftgxAtlasPage newPage;
+
+		newPage.texture = (uint8_t *) memalign(32, pageSize);
+		if(!newPage.texture)
+			return false;
+
+		memset(newPage.texture, 0x00, pageSize);
+		DCFlushRange(newPage.texture, pageSize);
+		GX_InitTexObj(&newPage.texObj, newPage.texture, FTGX_ATLAS_SIZE, FTGX_ATLAS_SIZE, GX_TF_I4, GX_CLAMP, GX_CLAMP, GX_FALSE);
+		newPage.shelfX = 0;
+		newPage.shelfY = 0;
+		newPage.shelfHeight = 0;
+
+		this->atlasPages.push_back(newPage);
+		page = &this->atlasPages.back();
+	}
+
+	charData->atlasPage = this->atlasPages.size() - 1;
+	charData->atlasX = page->shelfX;
+	charData->atlasY = page->shelfY;
+
+	page->shelfX += width;
+	if(height > page->shelfHeight)
+		page->shelfHeight = height;
+
+	return true;
+}
+
+/**
+ * Loads the rendered bitmap into the glyph's space in the atlas.
+ *
+ * This routine converts the glyph's rendered 8-bit grayscale bitmap to 4-bit intensities and writes it into the
+ * 8x8 texel tiles of the I4 atlas page, leaving a border of FTGX_ATLAS_PADDING empty texels around it.
  *
  * @param bmp	A pointer to the most recently rendered glyph's bitmap.
  * @param charData	A pointer to an allocated ftgxCharData structure whose data represent that of the last rendered glyph.
- *
- * Optimized for RGBA8 use by Dimok.
  */
 void FreeTypeGX::loadGlyphData(FT_Bitmap *bmp, ftgxCharData *charData)
 {
-	int glyphSize = (charData->textureWidth * charData->textureHeight) >> 1;
-
-	uint8_t *glyphData = (uint8_t *) memalign(32, glyphSize);
-	memset(glyphData, 0x00, glyphSize);
+	if(charData->textureWidth == 0)
+		return;
 
+	const int tilesPerRow = FTGX_ATLAS_SIZE >> 3;
+	uint8_t *texture = this->atlasPages[charData->atlasPage].texture;
 	uint8_t *src = (uint8_t *)bmp->buffer;
-	uint8_t *dst = glyphData;
-	int32_t pos, x1, y1, x, y;
+	int32_t x, y, tx, ty;
 
-	for(y1 = 0; y1 < bmp->rows; y1 += 8)
+	for(y = 0; y < (int32_t)bmp->rows; y++)
 	{
-		for(x1 = 0; x1 < bmp->width; x1 += 8)
-		{
-			for(y = y1; y < (y1 + 8); y++)
-			{
-				for(x = x1; x < (x1 + 8); x += 2, dst++)
-				{
-					if(x >= bmp->width || y >= bmp->rows)
-						continue;
+		ty = charData->atlasY + FTGX_ATLAS_PADDING + y;
+		uint8_t *row = texture + (ty >> 3) * tilesPerRow * 32 + (ty & 7) * 4;
 
-					pos = y * bmp->width + x;
-					*dst = (src[pos] & 0xF0);
+		for(x = 0; x < (int32_t)bmp->width; x++)
+		{
+			tx = charData->atlasX + FTGX_ATLAS_PADDING + x;
+			uint8_t *dst = row + (tx >> 3) * 32 + ((tx & 7) >> 1);
 
-					if(x+1 < bmp->width)
-						*dst |= (src[pos + 1] >> 4);
-				}
-			}
+			if(tx & 1)
+				*dst |= src[y * bmp->pitch + x] >> 4;
+			else
+				*dst |= src[y * bmp->pitch + x] & 0xF0;
 		}
 	}
 
-	DCFlushRange(glyphData, glyphSize);
-	charData->glyphDataTexture = glyphData;
+	// the glyph covers whole tile rows of the page
+	int rowSize = tilesPerRow * 32 * 8;
+	DCFlushRange(texture + (charData->atlasY >> 3) * rowSize, (charData->textureHeight >> 3) * rowSize);
+	this->atlasDirty = true;
 }
 
 /**
@@ -393,8 +505,8 @@ int16_t FreeTypeGX::getStyleOffsetHeight(ftgxDataOffset *offset, uint16_t format
 /**
  * Processes the supplied text string and prints the results at the specified coordinates.
  *
- * This routine processes each character of the supplied text string, loads the relevant preprocessed bitmap buffer,
- * a texture from said buffer, and loads the resultant texture into the EFB.
+ * This routine processes each character of the supplied text string and queues a quad for each glyph. The queued
+ * glyphs are then sent to the EFB in a single vertex batch per atlas page.
  *
  * @param x	Screen X coordinate at which to output the text.
  * @param y Screen Y coordinate at which to output the text. Note that this value corresponds to the text string origin and not the top or bottom of the glyphs.
@@ -407,9 +519,9 @@ uint16_t FreeTypeGX::drawText(int16_t x, int16_t y, wchar_t *text, GXColor color
 {
 	uint16_t x_pos = x, printed = 0;
 	uint16_t x_offset = 0, y_offset = 0;
-	GXTexObj glyphTexture;
 	FT_Vector pairDelta;
 	ftgxDataOffset offset;
+	ftgxCharData* prevData = NULL;
 
 	if(textStyle & FTGX_JUSTIFY_MASK)
 	{
@@ -421,36 +533,40 @@ uint16_t FreeTypeGX::drawText(int16_t x, int16_t y, wchar_t *text, GXColor color
 		y_offset = this->getStyleOffsetHeight(&offset, textStyle);
 	}
 
+	ChangeFontSize(this->ftPointSize);
+	this->glyphQueue.clear();
+
 	int i = 0;
 	while (text[i])
 	{
-		ftgxCharData* glyphData = NULL;
-		if (this->fontData.find(text[i]) != this->fontData.end())
-		{
-			glyphData = &this->fontData[text[i]];
-		}
-		else
-		{
-			glyphData = this->cacheGlyphData(text[i]);
-		}
+		ftgxCharData* glyphData = this->getGlyphData(text[i]);
 
 		if (glyphData != NULL)
 		{
-			if (this->ftKerningEnabled && i)
+			if (this->ftKerningEnabled && prevData)
 			{
-				FT_Get_Kerning(ftFace, this->fontData[text[i - 1]].glyphIndex, glyphData->glyphIndex, FT_KERNING_DEFAULT, &pairDelta);
+				FT_Get_Kerning(ftFace, prevData->glyphIndex, glyphData->glyphIndex, FT_KERNING_DEFAULT, &pairDelta);
 				x_pos += pairDelta.x >> 6;
 			}
 
-			GX_InitTexObj(&glyphTexture, glyphData->glyphDataTexture, glyphData->textureWidth, glyphData->textureHeight, GX_TF_I4, GX_CLAMP, GX_CLAMP, GX_FALSE);
-			this->copyTextureToFramebuffer(&glyphTexture, glyphData->textureWidth, glyphData->textureHeight, x_pos + glyphData->renderOffsetX + x_offset, y - glyphData->renderOffsetY + y_offset, color);
+			if(glyphData->textureWidth > 0)
+			{
+				ftgxGlyphQuad quad;
+				quad.screenX = x_pos + glyphData->renderOffsetX + x_offset - FTGX_ATLAS_PADDING;
+				quad.screenY = y - glyphData->renderOffsetY + y_offset - FTGX_ATLAS_PADDING;
+				quad.glyphData = glyphData;
+				this->glyphQueue.push_back(quad);
+			}
 
 			x_pos += glyphData->glyphAdvanceX;
+			prevData = glyphData;
 			++printed;
 		}
 		++i;
 	}
 
+	this->copyGlyphsToFramebuffer(color);
+
 	if(textStyle & FTGX_STYLE_MASK)
 	{
 		this->getOffset(text, &offset);
@@ -492,29 +608,25 @@ uint16_t FreeTypeGX::getWidth(wchar_t *text)
 {
 	uint16_t strWidth = 0;
 	FT_Vector pairDelta;
+	ftgxCharData* prevData = NULL;
+
+	ChangeFontSize(this->ftPointSize);
 
 	int i = 0;
 	while (text[i])
 	{
-		ftgxCharData* glyphData = NULL;
-		if (this->fontData.find(text[i]) != this->fontData.end())
-		{
-			glyphData = &this->fontData[text[i]];
-		}
-		else
-		{
-			glyphData = this->cacheGlyphData(text[i]);
-		}
+		ftgxCharData* glyphData = this->getGlyphData(text[i]);
 
 		if (glyphData != NULL)
 		{
-			if (this->ftKerningEnabled && (i > 0))
+			if (this->ftKerningEnabled && prevData)
 			{
-				FT_Get_Kerning(ftFace, this->fontData[text[i - 1]].glyphIndex, glyphData->glyphIndex, FT_KERNING_DEFAULT, &pairDelta);
+				FT_Get_Kerning(ftFace, prevData->glyphIndex, glyphData->glyphIndex, FT_KERNING_DEFAULT, &pairDelta);
 				strWidth += pairDelta.x >> 6;
 			}
 
 			strWidth += glyphData->glyphAdvanceX;
+			prevData = glyphData;
 		}
 		++i;
 	}
@@ -569,18 +681,12 @@ void FreeTypeGX::getOffset(wchar_t *text, ftgxDataOffset* offset)
 {
 	int16_t strMax = 0, strMin = 9999;
 
+	ChangeFontSize(this->ftPointSize);
+
 	int i = 0;
 	while (text[i])
 	{
-		ftgxCharData* glyphData = NULL;
-		if (this->fontData.find(text[i]) != this->fontData.end())
-		{
-			glyphData = &this->fontData[text[i]];
-		}
-		else
-		{
-			glyphData = this->cacheGlyphData(text[i]);
-		}
+		ftgxCharData* glyphData = this->getGlyphData(text[i]);
 
 		if(glyphData != NULL)
 		{
@@ -601,46 +707,96 @@ void FreeTypeGX::getOffset(wchar_t *text, ftgxDataOffset* offset)
  */
 void FreeTypeGX::getOffset(wchar_t const *text, ftgxDataOffset* offset)
 {
-	this->getOffset(text, offset);
+	this->getOffset((wchar_t *)text, offset);
 }
 
 /**
- * Copies the supplied texture quad to the EFB.
+ * Caches the glyphs of each character of the supplied string.
  *
- * This routine uses the in-built GX quad builder functions to define the texture bounds and location on the EFB target.
+ * Used to fill the atlas ahead of time, so that the first frames showing new text don't have to render glyphs.
  *
- * @param texObj	A pointer to the glyph's initialized texture object.
- * @param texWidth	The pixel width of the texture object.
- * @param texHeight	The pixel height of the texture object.
- * @param screenX	The screen X coordinate at which to output the rendered texture.
- * @param screenY	The screen Y coordinate at which to output the rendered texture.
- * @param color	Color to apply to the texture.
+ * @param text	NULL terminated string of characters to cache.
  */
-void FreeTypeGX::copyTextureToFramebuffer(GXTexObj *texObj, f32 texWidth, f32 texHeight, int16_t screenX, int16_t screenY, GXColor color)
+void FreeTypeGX::cacheText(wchar_t const *text)
 {
-	GX_LoadTexObj(texObj, GX_TEXMAP0);
-	GX_InvalidateTexAll();
+	for(int i = 0; text[i]; ++i)
+		this->getGlyphData(text[i]);
+}
+
+/**
+ * Copies the queued glyph quads to the EFB.
+ *
+ * This routine loads each atlas page used by the queued glyphs once and sends all the glyphs on that page in a
+ * single GX_QUADS batch. The texture cache is only invalidated when glyphs were added to the atlas.
+ *
+ * @param color	Color to apply to the glyphs.
+ */
+void FreeTypeGX::copyGlyphsToFramebuffer(GXColor color)
+{
+	size_t queued = this->glyphQueue.size();
+
+	if(queued == 0)
+		return;
+
+	if(this->atlasDirty)
+	{
+		GX_InvalidateTexAll();
+		this->atlasDirty = false;
+	}
 
 	GX_SetTevOp (GX_TEVSTAGE0, GX_MODULATE);
 	GX_SetVtxDesc (GX_VA_TEX0, GX_DIRECT);
 
-	GX_Begin(GX_QUADS, this->vertexIndex, 4);
-	GX_Position2s16(screenX, screenY);
-	GX_Color4u8(color.r, color.g, color.b, color.a);
-	GX_TexCoord2f32(0.0f, 0.0f);
+	const f32 texelSize = 1.0f / FTGX_ATLAS_SIZE;
 
-	GX_Position2s16(texWidth + screenX, screenY);
-	GX_Color4u8(color.r, color.g, color.b, color.a);
-	GX_TexCoord2f32(1.0f, 0.0f);
+	for(size_t page = 0; page < this->atlasPages.size(); page++)
+	{
+		uint16_t count = 0;
 
-	GX_Position2s16(texWidth + screenX, texHeight + screenY);
-	GX_Color4u8(color.r, color.g, color.b, color.a);
-	GX_TexCoord2f32(1.0f, 1.0f);
+		for(size_t i = 0; i < queued; i++)
+			if(this->glyphQueue[i].glyphData->atlasPage == page)
+				++count;
 
-	GX_Position2s16(screenX, texHeight + screenY);
-	GX_Color4u8(color.r, color.g, color.b, color.a);
-	GX_TexCoord2f32(0.0f, 1.0f);
-	GX_End();
+		if(count == 0)
+			continue;
+
+		GX_LoadTexObj(&this->atlasPages[page].texObj, GX_TEXMAP0);
+
+		GX_Begin(GX_QUADS, this->vertexIndex, 4 * count);
+
+		for(size_t i = 0; i < queued; i++)
+		{
+			ftgxGlyphQuad *quad = &this->glyphQueue[i];
+			ftgxCharData *glyphData = quad->glyphData;
+
+			if(glyphData->atlasPage != page)
+				continue;
+
+			int16_t texWidth = glyphData->textureWidth;
+			int16_t texHeight = glyphData->textureHeight;
+			f32 s0 = glyphData->atlasX * texelSize;
+			f32 t0 = glyphData->atlasY * texelSize;
+			f32 s1 = (glyphData->atlasX + texWidth) * texelSize;
+			f32 t1 = (glyphData->atlasY + texHeight) * texelSize;
+
+			GX_Position2s16(quad->screenX, quad->screenY);
+			GX_Color4u8(color.r, color.g, color.b, color.a);
+			GX_TexCoord2f32(s0, t0);
+
+			GX_Position2s16(texWidth + quad->screenX, quad->screenY);
+			GX_Color4u8(color.r, color.g, color.b, color.a);
+			GX_TexCoord2f32(s1, t0);
+
+			GX_Position2s16(texWidth + quad->screenX, texHeight + quad->screenY);
+			GX_Color4u8(color.r, color.g, color.b, color.a);
+			GX_TexCoord2f32(s1, t1);
+
+			GX_Position2s16(quad->screenX, texHeight + quad->screenY);
+			GX_Color4u8(color.r, color.g, color.b, color.a);
+			GX_TexCoord2f32(s0, t1);
+		}
+		GX_End();
+	}
 
 	this->setDefaultMode();
 }
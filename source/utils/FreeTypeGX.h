@@ -32,9 +32,13 @@
 #include <string.h>
 #include <wchar.h>
 #include <map>
+#include <vector>
 
 #define MAX_FONT_SIZE 100
 
+#define FTGX_ATLAS_SIZE		256	/**< Width and height of a glyph atlas page in texels. */
+#define FTGX_ATLAS_PADDING	1	/**< Empty texels kept around each glyph so filtering doesn't bleed into its neighbours. */
+
 /*! \struct ftgxCharData_
  *
  * Font face character glyph relevant data structure.
@@ -51,9 +55,33 @@ typedef struct ftgxCharData_ {
 	int16_t renderOffsetMax;	/**< Texture Y axis bearing maximum value. */
 	int16_t renderOffsetMin;	/**< Texture Y axis bearing minimum value. */
 
-	uint8_t* glyphDataTexture;	/**< Glyph texture bitmap data buffer. */
+	uint16_t atlasPage;			/**< Index of the atlas page holding the glyph texture. */
+	uint16_t atlasX;			/**< Texture X position of the glyph within its atlas page. */
+	uint16_t atlasY;			/**< Texture Y position of the glyph within its atlas page. */
 } ftgxCharData;
 
+/*! \struct ftgxAtlasPage_
+ *
+ * I4 texture page shared by the glyphs of one font size. Glyphs are packed onto shelves, left to right and top to bottom.
+ */
+typedef struct ftgxAtlasPage_ {
+	uint8_t* texture;			/**< Texture data buffer of the page. */
+	GXTexObj texObj;			/**< Texture object describing the page. */
+	uint16_t shelfX;			/**< X position of the next free space on the current shelf. */
+	uint16_t shelfY;			/**< Y position of the current shelf. */
+	uint16_t shelfHeight;		/**< Height of the tallest glyph on the current shelf. */
+} ftgxAtlasPage;
+
+/*! \struct ftgxGlyphQuad_
+ *
+ * Screen position of a glyph queued for drawing.
+ */
+typedef struct ftgxGlyphQuad_ {
+	int16_t screenX;			/**< Screen X coordinate of the glyph texture. */
+	int16_t screenY;			/**< Screen Y coordinate of the glyph texture. */
+	ftgxCharData *glyphData;	/**< Glyph to draw. */
+} ftgxGlyphQuad;
+
 /*! \struct ftgxDataOffset_
  *
  * Offset structure which hold both a maximum and minimum value.
@@ -111,6 +139,7 @@ void DeinitFreeType();
 void ChangeFontSize(FT_UInt pixelSize);
 wchar_t* charToWideChar(const char* p);
 void ClearFontData();
+void CacheFontData(const wchar_t* chars, FT_UInt pixelSize);
 
 /*! \class FreeTypeGX
  * \brief Wrapper class for the libFreeType library with GX rendering.
@@ -129,6 +158,9 @@ class FreeTypeGX {
 		uint8_t vertexIndex;	/**< Vertex format descriptor index. */
 		uint32_t compatibilityMode;	/**< Compatibility mode for default tev operations and vertex descriptors. */
 		std::map<wchar_t, ftgxCharData> fontData; /**< Map which holds the glyph data structures for the corresponding characters. */
+		std::vector<ftgxAtlasPage> atlasPages; /**< Texture pages holding the glyph bitmaps. */
+		std::vector<ftgxGlyphQuad> glyphQueue; /**< Glyphs of the string being drawn, reused between calls. */
+		bool atlasDirty;		/**< Flag indicating glyphs were added since the texture cache was last invalidated. */
 
 		static uint16_t adjustTextureWidth(uint16_t textureWidth);
 		static uint16_t adjustTextureHeight(uint16_t textureHeight);
@@ -138,13 +170,15 @@ class FreeTypeGX {
 
 		void unloadFont();
 		ftgxCharData *cacheGlyphData(wchar_t charCode);
+		ftgxCharData *getGlyphData(wchar_t charCode);
 		uint16_t cacheGlyphDataComplete();
+		bool allocateGlyphSpace(ftgxCharData *charData);
 		void loadGlyphData(FT_Bitmap *bmp, ftgxCharData *charData);
 
 		void setDefaultMode();
 
 		void drawTextFeature(int16_t x, int16_t y, uint16_t width, ftgxDataOffset *offsetData, uint16_t format, GXColor color);
-		void copyTextureToFramebuffer(GXTexObj *texObj, f32 texWidth, f32 texHeight, int16_t screenX, int16_t screenY, GXColor color);
+		void copyGlyphsToFramebuffer(GXColor color);
 		void copyFeatureToFramebuffer(f32 featureWidth, f32 featureHeight, int16_t screenX, int16_t screenY,  GXColor color);
 
 	public:
@@ -163,6 +197,7 @@ class FreeTypeGX {
 		uint16_t getHeight(wchar_t const *text);
 		void getOffset(wchar_t *text, ftgxDataOffset* offset);
 		void getOffset(wchar_t const *text, ftgxDataOffset* offset);
+		void cacheText(wchar_t const *text);
 };
 
 #endif /* FREETYPEGX_H_ */
@@ -3,289 +3,125 @@
 #include <stdio.h>
 #include <gctypes.h>
 #include <unistd.h>
+#include <algorithm>
 
 #include "gettext.h"
+#include "langtab.h"
 #include "../filelist.h"
 #include "../snes9xgx.h"
 
-typedef struct _MSG
-{
-	u32 id;
-	char* msgstr;
-	struct _MSG *next;
-} MSG;
-static MSG *baseMSG = 0;
-
-#define HASHWORDBITS 32
+// the table of the loaded language, embedded in the executable
+static const u8 *langTable = NULL;
+static u32 langBuckets = 0;
+static u32 langSlots = 0;
 
-/* Defines the so called `hashpjw' function by P.J. Weinberger
- [see Aho/Sethi/Ullman, COMPILERS: Principles, Techniques and Tools,
- 1986, 1987 Bell Telephone Laboratories, Inc.]  */
-static inline u32 hash_string(const char *str_param)
+static inline const u8 *entryAt(u32 slot)
 {
-	u32 hval, g;
-	const char *str = str_param;
-
-	/* Compute the hash value for the given string.  */
-	hval = 0;
-	while (*str != '\0')
-	{
-		hval <<= 4;
-		hval += (u8) * str++;
-		g = hval & ((u32) 0xf << (HASHWORDBITS - 4));
-		if (g != 0)
-		{
-			hval ^= g >> (HASHWORDBITS - 8);
-			hval ^= g;
-		}
-	}
-	return hval;
+	return langTable + LANGTAB_HEADER_SIZE + langBuckets * 4 + slot * 8;
 }
 
-/* Expand some escape sequences found in the argument string.  */
-static char *
-expand_escape(const char *str)
+static const char *findMSG(u32 id)
 {
-	char *retval, *rp;
-	const char *cp = str;
-
-	retval = (char *) malloc(strlen(str) + 1);
-	if (retval == NULL)
+	if (!langTable)
 		return NULL;
-	rp = retval;
-
-	while (cp[0] != '\0' && cp[0] != '\\')
-		*rp++ = *cp++;
-	if (cp[0] == '\0')
-		goto terminate;
-	do
-	{
-
-		/* Here cp[0] == '\\'.  */
-		switch (*++cp)
-		{
-		case '\"': /* " */
-			*rp++ = '\"';
-			++cp;
-			break;
-		case 'a': /* alert */
-			*rp++ = '\a';
-			++cp;
-			break;
-		case 'b': /* backspace */
-			*rp++ = '\b';
-			++cp;
-			break;
-		case 'f': /* form feed */
-			*rp++ = '\f';
-			++cp;
-			break;
-		case 'n': /* new line */
-			*rp++ = '\n';
-			++cp;
-			break;
-		case 'r': /* carriage return */
-			*rp++ = '\r';
-			++cp;
-			break;
-		case 't': /* horizontal tab */
-			*rp++ = '\t';
-			++cp;
-			break;
-		case 'v': /* vertical tab */
-			*rp++ = '\v';
-			++cp;
-			break;
-		case '\\':
-			*rp = '\\';
-			++cp;
-			break;
-		case '0':
-		case '1':
-		case '2':
-		case '3':
-		case '4':
-		case '5':
-		case '6':
-		case '7':
-		{
-			int ch = *cp++ - '0';
-
-			if (*cp >= '0' && *cp <= '7')
-			{
-				ch *= 8;
-				ch += *cp++ - '0';
-
-				if (*cp >= '0' && *cp <= '7')
-				{
-					ch *= 8;
-					ch += *cp++ - '0';
-				}
-			}
-			*rp = ch;
-		}
-			break;
-		default:
-			*rp = '\\';
-			break;
-		}
 
-		while (cp[0] != '\0' && cp[0] != '\\')
-			*rp++ = *cp++;
-	} while (cp[0] != '\0');
+	u32 disp = LangTabRead32(langTable + LANGTAB_HEADER_SIZE + LangTabBucket(id, langBuckets) * 4);
+	const u8 *entry = entryAt(LangTabSlot(id, disp, langSlots));
+	u32 offset = LangTabRead32(entry + 4);
 
-	/* Terminate string.  */
-	terminate: *rp = '\0';
-	return retval;
+	if (offset == 0 || LangTabRead32(entry) != id)
+		return NULL;
+	return (const char *) langTable + offset;
 }
 
-static MSG *findMSG(u32 id)
+bool LoadLanguage()
 {
-	MSG *msg;
-	for (msg = baseMSG; msg; msg = msg->next)
-	{
-		if (msg->id == id)
-			return msg;
-	}
-	return NULL;
-}
+	const u8 *file;
+	u32 size;
 
-static MSG *setMSG(const char *msgid, const char *msgstr)
-{
-	u32 id = hash_string(msgid);
-	MSG *msg = findMSG(id);
-	if (!msg)
-	{
-		msg = (MSG *) malloc(sizeof(MSG));
-		msg->id = id;
-		msg->msgstr = NULL;
-		msg->next = baseMSG;
-		baseMSG = msg;
-	}
-	if (msg)
+	switch(GCSettings.language)
 	{
-		if (msgstr)
-		{
-			if (msg->msgstr)
-				free(msg->msgstr);
-
-			msg->msgstr = expand_escape(msgstr);
-		}
-		return msg;
+		case LANG_JAPANESE: file = jp_langtab; size = jp_langtab_size; break;
+		case LANG_ENGLISH: file = en_langtab; size = en_langtab_size; break;
+		case LANG_GERMAN: file = de_langtab; size = de_langtab_size; break;
+		case LANG_FRENCH: file = fr_langtab; size = fr_langtab_size; break;
+		case LANG_SPANISH: file = es_langtab; size = es_langtab_size; break;
+		case LANG_ITALIAN: file = it_langtab; size = it_langtab_size; break;
+		case LANG_DUTCH: file = nl_langtab; size = nl_langtab_size; break;
+		case LANG_SIMP_CHINESE:
+		case LANG_TRAD_CHINESE: file = zh_langtab; size = zh_langtab_size; break;
+		case LANG_KOREAN: file = ko_langtab; size = ko_langtab_size; break;
+		case LANG_PORTUGUESE: file = pt_langtab; size = pt_langtab_size; break;
+		case LANG_BRAZILIAN_PORTUGUESE: file = pt_br_langtab; size = pt_br_langtab_size; break;
+		case LANG_CATALAN: file = ca_langtab; size = ca_langtab_size; break;
+		case LANG_TURKISH: file = tr_langtab; size = tr_langtab_size; break;
+		case LANG_SWEDISH: file = sv_langtab; size = sv_langtab_size; break;
+		default: return false;
 	}
-	return NULL;
-}
 
-static void gettextCleanUp(void)
-{
-	while (baseMSG)
-	{
-		MSG *nextMsg = baseMSG->next;
-		free(baseMSG->msgstr);
-		free(baseMSG);
-		baseMSG = nextMsg;
-	}
-}
+	langTable = NULL;
 
-static char * memfgets(char * dst, int maxlen, char * src)
-{
-	if(!src || !dst || maxlen <= 0)
-		return NULL;
+	if (size < LANGTAB_HEADER_SIZE || LangTabRead32(file) != LANGTAB_MAGIC)
+		return false;
 
-	char * newline = strchr(src, '\n');
+	u32 buckets = LangTabRead32(file + 8);
+	u32 slots = LangTabRead32(file + 12);
 
-	if(newline == NULL)
-		return NULL;
+	if (buckets == 0 || slots == 0 || (slots & (slots - 1)) ||
+		LANGTAB_HEADER_SIZE + (u64) buckets * 4 + (u64) slots * 8 > size)
+		return false;
 
-	memcpy(dst, src, (newline-src));
-	dst[(newline-src)] = 0;
-	return ++newline;
+	langTable = file;
+	langBuckets = buckets;
+	langSlots = slots;
+	return true;
 }
 
-bool LoadLanguage()
+/* Returns the characters used by the loaded translation and printable ASCII
+ * (untranslated strings), sorted and without duplicates. The caller must
+ * delete[] the returned string.  */
+wchar_t *GetLanguageCharset()
 {
-	char line[200];
-	char *lastID = NULL;
-	
-	char *file, *eof;
-	
-	switch(GCSettings.language)
+	size_t len = 0x7f - 0x20;
+	size_t n = 0;
+	u32 i;
+
+	for (i = 0; i < langSlots && langTable; i++)
 	{
-		case LANG_JAPANESE: file = (char *)jp_lang; eof = file + jp_lang_size; break;
-		case LANG_ENGLISH: file = (char *)en_lang; eof = file + en_lang_size; break;
-		case LANG_GERMAN: file = (char *)de_lang; eof = file + de_lang_size; break;
-		case LANG_FRENCH: file = (char *)fr_lang; eof = file + fr_lang_size; break;
-		case LANG_SPANISH: file = (char *)es_lang; eof = file + es_lang_size; break;
-		case LANG_ITALIAN: file = (char *)it_lang; eof = file + it_lang_size; break;
-		case LANG_DUTCH: file = (char *)nl_lang; eof = file + nl_lang_size; break;
-		case LANG_SIMP_CHINESE:
-		case LANG_TRAD_CHINESE: file = (char *)zh_lang; eof = file + zh_lang_size; break;
-		case LANG_KOREAN: file = (char *)ko_lang; eof = file + ko_lang_size; break;
-		case LANG_PORTUGUESE: file = (char *)pt_lang; eof = file + pt_lang_size; break;
-		case LANG_BRAZILIAN_PORTUGUESE: file = (char *)pt_br_lang; eof = file + pt_br_lang_size; break;
-		case LANG_CATALAN: file = (char *)ca_lang; eof = file + ca_lang_size; break;
-		case LANG_TURKISH: file = (char *)tr_lang; eof = file + tr_lang_size; break;
-		case LANG_SWEDISH: file = (char *)sv_lang; eof = file + sv_lang_size; break;
-		default: return false;
+		u32 offset = LangTabRead32(entryAt(i) + 4);
+		if (offset)
+			len += strlen((const char *) langTable + offset);
 	}
 
-	gettextCleanUp();
-
-	while (file && file < eof)
-	{
-		file = memfgets(line, sizeof(line), file);
+	wchar_t *chars = new wchar_t[len + 1];
 
-		if(!file)
-			break;
+	for (wchar_t c = 0x20; c < 0x7f; c++)
+		chars[n++] = c;
 
-		// lines starting with # are comments
-		if (line[0] == '#')
+	for (i = 0; i < langSlots && langTable; i++)
+	{
+		u32 offset = LangTabRead32(entryAt(i) + 4);
+		if (!offset)
 			continue;
 
-		if (strncmp(line, "msgid \"", 7) == 0)
-		{
-			char *msgid, *end;
-			if (lastID)
-			{
-				free(lastID);
-				lastID = NULL;
-			}
-			msgid = &line[7];
-			end = strrchr(msgid, '"');
-			if (end && end - msgid > 1)
-			{
-				*end = 0;
-				lastID = strdup(msgid);
-			}
-		}
-		else if (strncmp(line, "msgstr \"", 8) == 0)
-		{
-			char *msgstr, *end;
-
-			if (lastID == NULL)
-				continue;
-
-			msgstr = &line[8];
-			end = strrchr(msgstr, '"');
-			if (end && end - msgstr > 1)
-			{
-				*end = 0;
-				setMSG(lastID, msgstr);
-			}
-			free(lastID);
-			lastID = NULL;
-		}
+		int bt = mbstowcs(chars + n, (const char *) langTable + offset, len - n);
+		if (bt > 0)
+			n += bt;
 	}
-	return true;
+
+	std::sort(chars, chars + n);
+	n = std::unique(chars, chars + n) - chars;
+	chars[n] = 0;
+	return chars;
 }
 
 const char *gettext(const char *msgid)
 {
-	MSG *msg = findMSG(hash_string(msgid));
+	const char *msgstr = findMSG(LangTabHash(msgid));
 
-	if (msg && msg->msgstr)
+	if (msgstr)
 	{
-		return msg->msgstr;
+		return msgstr;
 	}
 	return msgid;
 }
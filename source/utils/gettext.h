@@ -1,7 +1,10 @@
 #ifndef _GETTEXT_H_
 #define _GETTEXT_H_
 
+#include <wchar.h>
+
 bool LoadLanguage();
+wchar_t *GetLanguageCharset();
 
 /*
  * input msg = a text in ASCII
@@ -0,0 +1,77 @@
+/****************************************************************************
+ * Snes9x Nintendo Wii/Gamecube Port
+ *
+ * Tantric 2008-2023
+ *
+ * langtab.h
+ *
+ * Layout of the translation tables that buildtools/langtab.c compiles from
+ * the .lang files, shared by the tool and gettext.cpp
+ *
+ * All values are big-endian u32s:
+ *   header   magic, count, buckets, slots
+ *   disp     one displacement per bucket
+ *   entries  slots x { msgid hash, offset of msgstr } - offset 0 is empty
+ *   strings  the translations with escapes expanded, NUL terminated
+ *
+ * A msgid is found in one probe: its hash picks a bucket, and the bucket's
+ * displacement picks the slot, which the tool chose so no two msgids in
+ * the table share one.
+ ***************************************************************************/
+
+#ifndef _LANGTAB_H_
+#define _LANGTAB_H_
+
+#include <stdint.h>
+
+#define LANGTAB_MAGIC		0x4C414E47	// "LANG"
+#define LANGTAB_HEADER_SIZE	16
+
+static inline uint32_t LangTabRead32(const unsigned char * p)
+{
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+/* Defines the so called `hashpjw' function by P.J. Weinberger
+ [see Aho/Sethi/Ullman, COMPILERS: Principles, Techniques and Tools,
+ 1986, 1987 Bell Telephone Laboratories, Inc.]  */
+static inline uint32_t LangTabHash(const char * str)
+{
+	uint32_t hval = 0, g;
+
+	while (*str != '\0')
+	{
+		hval <<= 4;
+		hval += (unsigned char) *str++;
+		g = hval & ((uint32_t) 0xf << 28);
+		if (g != 0)
+		{
+			hval ^= g >> 24;
+			hval ^= g;
+		}
+	}
+	return hval;
+}
+
+static inline uint32_t LangTabMix(uint32_t x)
+{
+	x ^= x >> 16;
+	x *= 0x7feb352d;
+	x ^= x >> 15;
+	x *= 0x846ca68b;
+	x ^= x >> 16;
+	return x;
+}
+
+static inline uint32_t LangTabBucket(uint32_t id, uint32_t buckets)
+{
+	return LangTabMix(id) % buckets;
+}
+
+// slots is a power of two
+static inline uint32_t LangTabSlot(uint32_t id, uint32_t disp, uint32_t slots)
+{
+	return LangTabMix(id ^ (disp * 0x9e3779b9 + 0x6a09e667)) & (slots - 1);
+}
+
+#endif
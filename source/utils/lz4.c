@@ -0,0 +1,235 @@
+/****************************************************************************
+ * Snes9x Nintendo Wii/Gamecube Port
+ *
+ * Tantric 2008-2023
+ *
+ * lz4.c
+ *
+ * LZ4 block compression
+ *
+ * A small implementation of the LZ4 block format - fast enough to compress
+ * a save state on every save, and much faster than zlib to decompress.
+ * Output is compatible with the reference LZ4_decompress_safe().
+ ***************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "lz4.h"
+
+#define LZ4_HASH_LOG		12
+#define LZ4_MIN_MATCH		4
+#define LZ4_MFLIMIT			12	// a match can't start in the last 12 bytes
+#define LZ4_LAST_LITERALS	5	// the last 5 bytes are always literals
+#define LZ4_MAX_OFFSET		65535
+#define LZ4_SKIP_TRIGGER	6	// search faster through incompressible data
+
+static unsigned int Read32(const unsigned char * p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+static unsigned int Hash(unsigned int v)
+{
+	return (v * 2654435761U) >> (32 - LZ4_HASH_LOG);
+}
+
+static unsigned char * WriteLength(unsigned char * op, int len)
+{
+	while(len >= 255)
+	{
+		*op++ = 255;
+		len -= 255;
+	}
+	*op++ = (unsigned char)len;
+	return op;
+}
+
+static unsigned char * WriteLiterals(unsigned char * op, const unsigned char * src, int len, unsigned char * token)
+{
+	if(len >= 15)
+	{
+		*token = 15 << 4;
+		op = WriteLength(op, len - 15);
+	}
+	else
+	{
+		*token = len << 4;
+	}
+	memcpy(op, src, len);
+	return op + len;
+}
+
+/****************************************************************************
+ * LZ4Compress
+ *
+ * Compresses srcSize bytes into dst, which must hold at least
+ * LZ4_COMPRESS_BOUND(srcSize) bytes. Returns the compressed size, or 0 if
+ * dst is too small. The 16KB hash table is allocated for each call - it is
+ * too big for the screenshot thread's stack, and a static table could be
+ * shared by a save and a thumbnail compressing at the same time
+ ***************************************************************************/
+int LZ4Compress(const unsigned char * src, int srcSize, unsigned char * dst, int dstCapacity)
+{
+	int * table;
+	unsigned char * op = dst;
+	unsigned char * token;
+	int anchor = 0;
+	int ip = 1;
+
+	if(srcSize < 0 || dstCapacity < LZ4_COMPRESS_BOUND(srcSize))
+		return 0;
+
+	table = (int *)malloc(sizeof(int) << LZ4_HASH_LOG);
+
+	if(!table)
+		return 0;
+
+	memset(table, 0xff, sizeof(int) << LZ4_HASH_LOG);
+
+	if(srcSize > LZ4_MFLIMIT)
+	{
+		const int matchStartLimit = srcSize - LZ4_MFLIMIT;
+		const int matchEndLimit = srcSize - LZ4_LAST_LITERALS;
+
+		table[Hash(Read32(src))] = 0;
+
+		while(ip <= matchStartLimit)
+		{
+			unsigned int seq = Read32(src + ip);
+			unsigned int h = Hash(seq);
+			int ref = table[h];
+			table[h] = ip;
+
+			if(ref < 0 || ip - ref > LZ4_MAX_OFFSET || Read32(src + ref) != seq)
+			{
+				ip += 1 + ((ip - anchor) >> LZ4_SKIP_TRIGGER);
+				continue;
+			}
+
+			// grow the match in both directions
+			while(ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1])
+			{
+				ip--;
+				ref--;
+			}
+
+			int len = LZ4_MIN_MATCH;
+			while(ip + len < matchEndLimit && src[ip + len] == src[ref + len])
+				len++;
+
+			token = op++;
+			op = WriteLiterals(op, src + anchor, ip - anchor, token);
+
+			*op++ = (unsigned char)(ip - ref);
+			*op++ = (unsigned char)((ip - ref) >> 8);
+
+			int matchLen = len - LZ4_MIN_MATCH;
+			if(matchLen >= 15)
+			{
+				*token |= 15;
+				op = WriteLength(op, matchLen - 15);
+			}
+			else
+			{
+				*token |= matchLen;
+			}
+
+			ip += len;
+			anchor = ip;
+
+			// helps the next search find a match that starts inside this one
+			table[Hash(Read32(src + ip - 2))] = ip - 2;
+		}
+	}
+
+	free(table);
+
+	token = op++;
+	op = WriteLiterals(op, src + anchor, srcSize - anchor, token);
+	return op - dst;
+}
+
+/****************************************************************************
+ * LZ4Decompress
+ *
+ * Decompresses an LZ4 block into dst. Never reads or writes outside of the
+ * given buffers. Returns the decompressed size, or -1 if the data is corrupt
+ ***************************************************************************/
+int LZ4Decompress(const unsigned char * src, int srcSize, unsigned char * dst, int dstCapacity)
+{
+	int ip = 0;
+	int op = 0;
+
+	while(ip < srcSize)
+	{
+		int token = src[ip++];
+		int len = token >> 4;
+		int b;
+
+		if(len == 15)
+		{
+			do
+			{
+				if(ip >= srcSize)
+					return -1;
+				b = src[ip++];
+				len += b;
+			} while(b == 255);
+		}
+
+		if(len > srcSize - ip || len > dstCapacity - op)
+			return -1;
+
+		memcpy(dst + op, src + ip, len);
+		ip += len;
+		op += len;
+
+		if(ip == srcSize) // the last sequence has no match
+			break;
+
+		if(ip + 2 > srcSize)
+			return -1;
+
+		int offset = src[ip] | (src[ip + 1] << 8);
+		ip += 2;
+
+		if(offset == 0 || offset > op)
+			return -1;
+
+		len = token & 15;
+
+		if(len == 15)
+		{
+			do
+			{
+				if(ip >= srcSize)
+					return -1;
+				b = src[ip++];
+				len += b;
+			} while(b == 255);
+		}
+
+		len += LZ4_MIN_MATCH;
+
+		if(len > dstCapacity - op)
+			return -1;
+
+		unsigned char * d = dst + op;
+		const unsigned char * m = d - offset;
+
+		if(offset >= len)
+		{
+			memcpy(d, m, len);
+		}
+		else
+		{
+			// overlapping copy repeats the last offset bytes
+			for(int i=0; i < len; i++)
+				d[i] = m[i];
+		}
+
+		op += len;
+	}
+	return op;
+}
@@ -0,0 +1,28 @@
+/****************************************************************************
+ * Snes9x Nintendo Wii/Gamecube Port
+ *
+ * Tantric 2008-2023
+ *
+ * lz4.h
+ *
+ * LZ4 block compression
+ ***************************************************************************/
+
+#ifndef _LZ4_H_
+#define _LZ4_H_
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+// worst case size of the compressed data for size input bytes
+#define LZ4_COMPRESS_BOUND(size) ((size) + ((size) / 255) + 16)
+
+int LZ4Compress(const unsigned char * src, int srcSize, unsigned char * dst, int dstCapacity);
+int LZ4Decompress(const unsigned char * src, int srcSize, unsigned char * dst, int dstCapacity);
+
+#ifdef __cplusplus
+	}
+#endif
+
+#endif
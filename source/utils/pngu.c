@@ -12,11 +12,16 @@
 #include <string.h>
 #include "pngu.h"
 #include <png.h>
+#include <zlib.h>
 
 // Constants
 #define PNGU_SOURCE_BUFFER				1
 #define PNGU_SOURCE_DEVICE				2
 
+// Largest image DecodePNGFromFile will decode (the EFB size)
+#define PNGU_MAX_WIDTH					640
+#define PNGU_MAX_HEIGHT					528
+
 // Return codes
 #define PNGU_OK							0
 #define PNGU_ODD_WIDTH					1
@@ -576,7 +581,10 @@ u8 * DecodePNG(const u8 *src, int * width, int * height, u8 *dstPtr, int maxwidt
 	return dst;
 }
 
-u8 * DecodePNGFromFile(const char *filepath, int * width, int * height, u8 *dstPtr, int maxwidth, int maxheight)
+// Images larger than maxwidth x maxheight are rejected. With fit set they are
+// scaled down instead, and only images larger than the EFB are rejected, to
+// keep the temporary decode buffer bounded
+u8 * DecodePNGFromFile(const char *filepath, int * width, int * height, u8 *dstPtr, int maxwidth, int maxheight, int fit)
 {
 	FILE *file = fopen (filepath, "rb");
 
@@ -586,20 +594,25 @@ u8 * DecodePNGFromFile(const char *filepath, int * width, int * height, u8 *dstP
 	IMGCTX ctx = PNGU_SelectImageFromDevice(filepath);
 
 	if(!ctx)
+	{
+		fclose (file);
 		return NULL;
+	}
 
 	ctx->fd = file;
 	PNGUPROP imgProp;
 	u8 *dst = NULL;
+	int limitwidth = fit ? PNGU_MAX_WIDTH : maxwidth;
+	int limitheight = fit ? PNGU_MAX_HEIGHT : maxheight;
 
-	if(PNGU_GetImageProperties(ctx, &imgProp) == PNGU_OK && imgProp.imgWidth <= maxwidth && imgProp.imgHeight <= maxheight)
+	if(PNGU_GetImageProperties(ctx, &imgProp) == PNGU_OK && imgProp.imgWidth <= limitwidth && imgProp.imgHeight <= limitheight)
 		dst = PNGU_DecodeTo4x4RGBA8 (ctx, imgProp.imgWidth, imgProp.imgHeight, width, height, dstPtr, maxwidth, maxheight);
 
 	PNGU_ReleaseImageContext (ctx);
 	return dst;
 }
 
-int PNGU_EncodeFromRGB (IMGCTX ctx, u32 width, u32 height, void *buffer, u32 stride)
+int PNGU_EncodeFromRGB (IMGCTX ctx, u32 width, u32 height, void *buffer, u32 stride, int level)
 {
 	png_uint_32 rowbytes;
 	u32 y;
@@ -655,6 +668,8 @@ int PNGU_EncodeFromRGB (IMGCTX ctx, u32 width, u32 height, void *buffer, u32 str
     png_set_IHDR (ctx->png_ptr, ctx->info_ptr, width, height, 8, PNG_COLOR_TYPE_RGB, 
 				PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
 
+	png_set_compression_level (ctx->png_ptr, level);
+
 	// Allocate memory to store the image in RGB format
 	rowbytes = width * 3;
 	if (rowbytes % 4)
@@ -739,7 +754,7 @@ int PNGU_EncodeFromGXTexture (IMGCTX ctx, u32 width, u32 height, void *buffer, u
 		}
 	}
 	
-	res = PNGU_EncodeFromRGB (ctx, width, height, tmpbuffer, stride);
+	res = PNGU_EncodeFromRGB (ctx, width, height, tmpbuffer, stride, Z_DEFAULT_COMPRESSION);
 	free(tmpbuffer);
 	return res;
 }
@@ -769,7 +784,7 @@ int PNGU_EncodeFromEFB (IMGCTX ctx, u32 width, u32 height)
 		}
 	}
 
-	res = PNGU_EncodeFromRGB (ctx, width, height, tmpbuffer, 0);
+	res = PNGU_EncodeFromRGB (ctx, width, height, tmpbuffer, 0, Z_DEFAULT_COMPRESSION);
 	free(tmpbuffer);
 	return res;
 }
@@ -808,6 +808,7 @@ MakeTexture_Scalar (const void *src, void *dst, s32 width, s32 height)
  ***************************************************************************/
 uint32 prevRenderedFrameCount = 0;
 int fscale = 1;
+static bool textureFiltered = true; // texturemem doesn't hold the last unfiltered frame
 
 // Optional lightweight debug logging (define DEBUG_VIDEO in build flags to enable)
 #ifdef DEBUG_VIDEO
@@ -839,6 +840,8 @@ update_video (int width, int height)
 	if (oldvheight != vheight || oldvwidth != vwidth)	// if rendered width/height changes, update scaling
 		CheckVideo = 1;
 
+	bool fullTexture = CheckVideo || textureFiltered;
+
 	if (CheckVideo)	// if we get back from the menu, and have rendered at least 1 frame
 	{
 		int xscale, yscale;
@@ -924,9 +927,6 @@ update_video (int width, int height)
 			fscale = 1;
 		}
 	}
-	// Determine actual texture dimensions based on filtering
-	u32 actualTexWidth, actualTexHeight;
-	
 	if (filterIdLocal != FILTER_NONE && vheight <= 239 && vwidth <= 256 && FilterMethod)
 	{
 		// Copy function pointer locally to avoid race if changed by menu thread
@@ -934,21 +934,40 @@ update_video (int width, int height)
 		if (fm)
 			fm ((uint8*) GFX.Screen, EXT_PITCH, (uint8*) filtermem, vwidth*fscale*2, vwidth, vheight);
 		MakeTexture565((char *) filtermem, (char *) texturemem, vwidth*fscale, vheight*fscale);
-		actualTexWidth = vwidth * fscale;
-		actualTexHeight = vheight * fscale;
+		// Flush only the actual texture size being used (RGB565 = 2 bytes per pixel)
+		// This is much more efficient than flushing the entire 512x520 buffer (532,480 bytes)
+		// Typical savings: 256x224 = 112KB vs 520KB (79% reduction)
+		DCFlushRange (texturemem, vwidth * fscale * vheight * fscale * 2);
+		textureFiltered = true;
 	}
 	else
 	{
-		MakeTexture((char *) GFX.Screen, (char *) texturemem, vwidth, vheight);
-		actualTexWidth = vwidth;
-		actualTexHeight = vheight;
+		// The texture still holds the last frame, so only convert the rows the
+		// core redrew. The texture is made of 4x4 tiles, so whole tile rows are
+		// converted: 4 rows of GFX.Screen make one tile row of vwidth*8 bytes
+		int firstBlock = 0;
+		int endBlock = vheight >> 2;
+
+		if (!fullTexture)
+		{
+			firstBlock = GFX.DirtyFirstRow >> 2;
+			if (GFX.DirtyLastRow < 0)
+				endBlock = 0;
+			else if ((GFX.DirtyLastRow >> 2) + 1 < endBlock)
+				endBlock = (GFX.DirtyLastRow >> 2) + 1;
+		}
+
+		if (firstBlock < endBlock)
+		{
+			u8 *src = (u8 *) GFX.Screen + firstBlock * 4 * EXT_PITCH;
+			u8 *dst = texturemem + firstBlock * vwidth * 8;
+
+			MakeTexture(src, dst, vwidth, (endBlock - firstBlock) * 4);
+			DCFlushRange (dst, (endBlock - firstBlock) * vwidth * 8);
+		}
+		textureFiltered = false;
 	}
 
-	// Flush only the actual texture size being used (RGB565 = 2 bytes per pixel)
-	// This is much more efficient than flushing the entire 512x520 buffer (532,480 bytes)
-	// Typical savings: 256x224 = 112KB vs 520KB (79% reduction)
-	u32 textureSize = actualTexWidth * actualTexHeight * 2;
-	DCFlushRange (texturemem, textureSize);	// update the texture memory
 	GX_InvalidateTexAll ();
 
 	draw_square (view);		// draw the quad
@@ -0,0 +1,297 @@
+#include "../framework/simple_test.h"
+#include "../mocks/mock_libogc.h"
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <stdint.h>
+
+// Test the Cx4 scale/rotate and wireframe fast paths (c4emu.cpp, c4.cpp)
+// against the code they replaced
+
+#define TEST_C4_PI 3.14159265
+
+// The parameters of a scale/rotate command: the matrix, the size and the
+// centre of the image
+struct TestScaleRotate {
+    int16_t A, B, C, D;
+    uint8_t w, h;
+    int32_t Cx, Cy;
+    int row_padding;
+};
+
+// Writes the image one bit at a time, as C4DoScaleRotate() used to
+static void TestScaleRotatePerPixel(const TestScaleRotate &p, uint8_t *ram) {
+    memset(ram, 0, (p.w + p.row_padding / 4) * p.h / 2);
+
+    int32_t LineX = (p.Cx << 12) - p.Cx * p.A - p.Cx * p.B;
+    int32_t LineY = (p.Cy << 12) - p.Cy * p.C - p.Cy * p.D;
+    int outidx = 0;
+    uint8_t bit = 0x80;
+
+    for (int y = 0; y < p.h; y++) {
+        uint32_t X = LineX;
+        uint32_t Y = LineY;
+
+        for (int x = 0; x < p.w; x++) {
+            uint8_t byte;
+            if ((X >> 12) >= p.w || (Y >> 12) >= p.h)
+                byte = 0;
+            else {
+                uint32_t addr = (Y >> 12) * p.w + (X >> 12);
+                byte = ram[0x600 + (addr >> 1)];
+                if (addr & 1)
+                    byte >>= 4;
+            }
+
+            if (byte & 1) ram[outidx] |= bit;
+            if (byte & 2) ram[outidx + 1] |= bit;
+            if (byte & 4) ram[outidx + 16] |= bit;
+            if (byte & 8) ram[outidx + 17] |= bit;
+
+            bit >>= 1;
+            if (bit == 0) {
+                bit = 0x80;
+                outidx += 32;
+            }
+
+            X += p.A;
+            Y += p.C;
+        }
+
+        outidx += 2 + p.row_padding;
+        if (outidx & 0x10)
+            outidx &= ~0x10;
+        else
+            outidx -= p.w * 4 + p.row_padding;
+
+        LineX += p.B;
+        LineY += p.D;
+    }
+}
+
+// Spreads the 4 bits of a pixel to bit 0 of one byte per bitplane
+static uint32_t TestPlaneBits(uint8_t byte) {
+    return (byte & 1) | ((byte & 2) << 7) | ((byte & 4) << 14) | ((uint32_t)(byte & 8) << 21);
+}
+
+// Builds each group of 8 pixels in a register and stores it once
+static void TestScaleRotatePerGroup(const TestScaleRotate &p, uint8_t *ram) {
+    memset(ram, 0, (p.w + p.row_padding / 4) * p.h / 2);
+
+    int32_t LineX = (p.Cx << 12) - p.Cx * p.A - p.Cx * p.B;
+    int32_t LineY = (p.Cy << 12) - p.Cy * p.C - p.Cy * p.D;
+    int outidx = 0;
+
+    for (int y = 0; y < p.h; y++) {
+        uint32_t X = LineX;
+        uint32_t Y = LineY;
+
+        for (int x = 0; x < p.w; x += 8) {
+            uint32_t planes = 0;
+
+            for (int i = 0; i < 8; i++) {
+                uint8_t byte;
+                if ((X >> 12) >= p.w || (Y >> 12) >= p.h)
+                    byte = 0;
+                else {
+                    uint32_t addr = (Y >> 12) * p.w + (X >> 12);
+                    uint32_t src = 0x600 + (addr >> 1);
+                    byte = ram[src];
+
+                    // the bits of its own group that are not stored yet
+                    uint32_t d = src - outidx;
+                    if ((d & ~0x11) == 0)
+                        byte |= (uint8_t)((planes >> (((d & 1) | (d >> 3)) * 8)) << (8 - i));
+
+                    if (addr & 1)
+                        byte >>= 4;
+                }
+
+                planes = (planes << 1) | TestPlaneBits(byte & 0x0f);
+
+                X += p.A;
+                Y += p.C;
+            }
+
+            ram[outidx] |= (uint8_t)planes;
+            ram[outidx + 1] |= (uint8_t)(planes >> 8);
+            ram[outidx + 16] |= (uint8_t)(planes >> 16);
+            ram[outidx + 17] |= (uint8_t)(planes >> 24);
+            outidx += 32;
+        }
+
+        outidx += 2 + p.row_padding;
+        if (outidx & 0x10)
+            outidx &= ~0x10;
+        else
+            outidx -= p.w * 4 + p.row_padding;
+
+        LineX += p.B;
+        LineY += p.D;
+    }
+}
+
+static void TestRandomRAM(uint8_t *ram, int size) {
+    for (int i = 0; i < size; i++)
+        ram[i] = rand() & 0xff;
+}
+
+static TestScaleRotate TestRandomScaleRotate(int row_padding) {
+    TestScaleRotate p;
+    int16_t scale = 0x800 + rand() % 0x1000;
+    double angle = (rand() % 512) * TEST_C4_PI * 2 / 512;
+
+    p.A = (int16_t)(cos(angle) * scale);
+    p.B = (int16_t)(-sin(angle) * scale);
+    p.C = (int16_t)(sin(angle) * scale);
+    p.D = (int16_t)(cos(angle) * scale);
+    p.w = (rand() % 72) & ~7;
+    p.h = (rand() % 72) & ~7;
+    p.Cx = p.w / 2 + rand() % 3 - 1;
+    p.Cy = p.h / 2 + rand() % 3 - 1;
+    p.row_padding = row_padding;
+    return p;
+}
+
+// A vertex rotation as C4TransfWireFrame2() did it, with the sines and
+// cosines worked out for every call
+static void TestTransformPerCall(int16_t angles[3], int16_t scale, int16_t in[3], int16_t out[2]) {
+    double x = in[0], y = in[1], z = in[2];
+    double x2, y2, z2, t;
+
+    t = -(double)angles[0] * TEST_C4_PI * 2 / 128;
+    y2 = y * cos(t) - z * sin(t);
+    z2 = y * sin(t) + z * cos(t);
+
+    t = -(double)angles[1] * TEST_C4_PI * 2 / 128;
+    x2 = x * cos(t) + z2 * sin(t);
+    z = x * -sin(t) + z2 * cos(t);
+
+    t = -(double)angles[2] * TEST_C4_PI * 2 / 128;
+    x = x2 * cos(t) - y2 * sin(t);
+    y = x2 * sin(t) + y2 * cos(t);
+
+    out[0] = (int16_t)(x * (double)scale / 0x100);
+    out[1] = (int16_t)(y * (double)scale / 0x100);
+}
+
+// The same rotation with the sines and cosines kept between calls, as in
+// C4UpdateRotation()
+struct TestRotation {
+    bool valid;
+    int16_t angles[3];
+    double cosv[3], sinv[3];
+};
+
+static void TestTransformCached(TestRotation &r, int16_t angles[3], int16_t scale, int16_t in[3], int16_t out[2]) {
+    if (!r.valid || memcmp(r.angles, angles, sizeof(r.angles))) {
+        for (int i = 0; i < 3; i++) {
+            double t = -(double)angles[i] * TEST_C4_PI * 2 / 128;
+            r.cosv[i] = cos(t);
+            r.sinv[i] = sin(t);
+            r.angles[i] = angles[i];
+        }
+        r.valid = true;
+    }
+
+    double x = in[0], y = in[1], z = in[2];
+    double x2, y2, z2;
+
+    y2 = y * r.cosv[0] - z * r.sinv[0];
+    z2 = y * r.sinv[0] + z * r.cosv[0];
+
+    x2 = x * r.cosv[1] + z2 * r.sinv[1];
+    z = x * -r.sinv[1] + z2 * r.cosv[1];
+
+    x = x2 * r.cosv[2] - y2 * r.sinv[2];
+    y = x2 * r.sinv[2] + y2 * r.cosv[2];
+
+    out[0] = (int16_t)(x * (double)scale / 0x100);
+    out[1] = (int16_t)(y * (double)scale / 0x100);
+}
+
+// Tests for the Cx4 fast paths
+TEST(c4_scale_rotate_groups_match_per_pixel) {
+    static uint8_t expected[0x2000];
+    static uint8_t actual[0x2000];
+    srand(4321);
+
+    for (int n = 0; n < 2000; n++) {
+        TestScaleRotate p = TestRandomScaleRotate((n & 1) ? 64 : 0);
+
+        TestRandomRAM(expected, sizeof(expected));
+        memcpy(actual, expected, sizeof(actual));
+
+        TestScaleRotatePerPixel(p, expected);
+        TestScaleRotatePerGroup(p, actual);
+        ASSERT_EQ(0, memcmp(expected, actual, sizeof(actual)));
+    }
+}
+
+TEST(c4_scale_rotate_output_overlapping_source) {
+    static uint8_t expected[0x2000];
+    static uint8_t actual[0x2000];
+    srand(2468);
+
+    // 64x64 images write past 0x600, where the source starts
+    for (int n = 0; n < 2000; n++) {
+        TestScaleRotate p = TestRandomScaleRotate((n & 1) ? 64 : 0);
+        p.w = 64;
+        p.h = 64;
+        p.Cx = 32;
+        p.Cy = 32;
+
+        TestRandomRAM(expected, sizeof(expected));
+        memcpy(actual, expected, sizeof(actual));
+
+        TestScaleRotatePerPixel(p, expected);
+        TestScaleRotatePerGroup(p, actual);
+        ASSERT_EQ(0, memcmp(expected, actual, sizeof(actual)));
+    }
+}
+
+TEST(c4_scale_rotate_out_of_range_is_blank) {
+    static uint8_t ram[0x2000];
+    srand(99);
+    TestRandomRAM(ram, sizeof(ram));
+
+    // every source pixel falls outside of the image
+    TestScaleRotate p;
+    p.A = 0x7fff;
+    p.B = 0;
+    p.C = 0;
+    p.D = 0x7fff;
+    p.w = 32;
+    p.h = 32;
+    p.Cx = -64;
+    p.Cy = -64;
+    p.row_padding = 0;
+
+    TestScaleRotatePerGroup(p, ram);
+    for (int i = 0; i < 32 * 32 / 2; i++)
+        ASSERT_EQ(0, ram[i]);
+}
+
+TEST(c4_wireframe_cached_rotation_matches) {
+    TestRotation r;
+    memset(&r, 0, sizeof(r));
+    srand(777);
+
+    for (int shape = 0; shape < 2000; shape++) {
+        int16_t angles[3];
+        for (int i = 0; i < 3; i++)
+            angles[i] = rand() & 0xff;
+        int16_t scale = rand() & 0xff;
+
+        for (int v = 0; v < 16; v++) {
+            int16_t in[3], expected[2], actual[2];
+            for (int i = 0; i < 3; i++)
+                in[i] = (int16_t)(rand() % 0x400 - 0x200);
+
+            TestTransformPerCall(angles, scale, in, expected);
+            TestTransformCached(r, angles, scale, in, actual);
+            ASSERT_EQ(expected[0], actual[0]);
+            ASSERT_EQ(expected[1], actual[1]);
+        }
+    }
+}
@@ -0,0 +1,246 @@
+#include "../framework/simple_test.h"
+#include "../mocks/mock_libogc.h"
+#include <cstring>
+#include <cstdlib>
+#include <stdint.h>
+
+// Test the table-driven DSP-1 math (dsp1.cpp) against the routines it replaced
+
+// DSP1ROM[0x20] - DSP1ROM[0xe7]: the powers of two used to normalize and
+// truncate, and the initial guesses for the inverse
+static const uint16_t TestDSP1ROMSlice[0xc8] = {
+    0x0000, 0x0000, 0x0001, 0x0002, 0x0004, 0x0008, 0x0010, 0x0020,
+    0x0040, 0x0080, 0x0100, 0x0200, 0x0400, 0x0800, 0x1000, 0x2000,
+    0x4000, 0x7fff, 0x4000, 0x2000, 0x1000, 0x0800, 0x0400, 0x0200,
+    0x0100, 0x0080, 0x0040, 0x0020, 0x0001, 0x0008, 0x0004, 0x0002,
+    0x0001, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x8000, 0xffe5, 0x0100, 0x7fff, 0x7f02, 0x7e08,
+    0x7d12, 0x7c1f, 0x7b30, 0x7a45, 0x795d, 0x7878, 0x7797, 0x76ba,
+    0x75df, 0x7507, 0x7433, 0x7361, 0x7293, 0x71c7, 0x70fe, 0x7038,
+    0x6f75, 0x6eb4, 0x6df6, 0x6d3a, 0x6c81, 0x6bca, 0x6b16, 0x6a64,
+    0x69b4, 0x6907, 0x685b, 0x67b2, 0x670b, 0x6666, 0x65c4, 0x6523,
+    0x6484, 0x63e7, 0x634c, 0x62b3, 0x621c, 0x6186, 0x60f2, 0x6060,
+    0x5fd0, 0x5f41, 0x5eb5, 0x5e29, 0x5d9f, 0x5d17, 0x5c91, 0x5c0c,
+    0x5b88, 0x5b06, 0x5a85, 0x5a06, 0x5988, 0x590b, 0x5890, 0x5816,
+    0x579d, 0x5726, 0x56b0, 0x563b, 0x55c8, 0x5555, 0x54e4, 0x5474,
+    0x5405, 0x5398, 0x532b, 0x52bf, 0x5255, 0x51ec, 0x5183, 0x511c,
+    0x50b6, 0x5050, 0x4fec, 0x4f89, 0x4f26, 0x4ec5, 0x4e64, 0x4e05,
+    0x4da6, 0x4d48, 0x4cec, 0x4c90, 0x4c34, 0x4bda, 0x4b81, 0x4b28,
+    0x4ad0, 0x4a79, 0x4a23, 0x49cd, 0x4979, 0x4925, 0x48d1, 0x487f,
+    0x482d, 0x47dc, 0x478c, 0x473c, 0x46ed, 0x469f, 0x4651, 0x4604,
+    0x45b8, 0x456c, 0x4521, 0x44d7, 0x448d, 0x4444, 0x43fc, 0x43b4,
+    0x436d, 0x4326, 0x42e0, 0x429a, 0x4255, 0x4211, 0x41cd, 0x4189,
+    0x4146, 0x4104, 0x40c2, 0x4081, 0x4040, 0x3fff, 0x41f7, 0x43e1,
+};
+
+static uint16_t TestDSP1ROM(int index) {
+    return TestDSP1ROMSlice[index - 0x20];
+}
+
+// Inverse as the DSP-1 computes it: initial guess and two Newton iterations
+static void TestInverseNewton(int16_t Coefficient, int16_t Exponent, int16_t *iCoefficient, int16_t *iExponent) {
+    if (Coefficient == 0x0000) {
+        *iCoefficient = 0x7fff;
+        *iExponent = 0x002f;
+        return;
+    }
+
+    int16_t Sign = 1;
+    if (Coefficient < 0) {
+        if (Coefficient < -32767)
+            Coefficient = -32767;
+        Coefficient = -Coefficient;
+        Sign = -1;
+    }
+
+    while (Coefficient < 0x4000) {
+        Coefficient <<= 1;
+        Exponent--;
+    }
+
+    if (Coefficient == 0x4000) {
+        if (Sign == 1)
+            *iCoefficient = 0x7fff;
+        else {
+            *iCoefficient = -0x4000;
+            Exponent--;
+        }
+    } else {
+        int16_t i = TestDSP1ROM(((Coefficient - 0x4000) >> 7) + 0x0065);
+        i = (i + (-i * (Coefficient * i >> 15) >> 15)) << 1;
+        i = (i + (-i * (Coefficient * i >> 15) >> 15)) << 1;
+        *iCoefficient = i * Sign;
+    }
+
+    *iExponent = 1 - Exponent;
+}
+
+// Table-driven inverse, built the way DSP1_BuildTables() builds it
+static int16_t TestInverseTable[0x4000];
+
+static void TestBuildInverseTable() {
+    for (int c = 0x4000; c < 0x8000; c++) {
+        int16_t Coefficient = c;
+        int16_t i = TestDSP1ROM(((Coefficient - 0x4000) >> 7) + 0x0065);
+        i = (i + (-i * (Coefficient * i >> 15) >> 15)) << 1;
+        i = (i + (-i * (Coefficient * i >> 15) >> 15)) << 1;
+        TestInverseTable[c - 0x4000] = i;
+    }
+}
+
+static void TestInverseTableDriven(int16_t Coefficient, int16_t Exponent, int16_t *iCoefficient, int16_t *iExponent) {
+    if (Coefficient == 0x0000) {
+        *iCoefficient = 0x7fff;
+        *iExponent = 0x002f;
+        return;
+    }
+
+    int16_t Sign = 1;
+    if (Coefficient < 0) {
+        if (Coefficient < -32767)
+            Coefficient = -32767;
+        Coefficient = -Coefficient;
+        Sign = -1;
+    }
+
+    const int shift = __builtin_clz(Coefficient) - (8 * sizeof(int) - 15);
+    Coefficient <<= shift;
+    Exponent -= shift;
+
+    if (Coefficient == 0x4000) {
+        if (Sign == 1)
+            *iCoefficient = 0x7fff;
+        else {
+            *iCoefficient = -0x4000;
+            Exponent--;
+        }
+    } else {
+        *iCoefficient = TestInverseTable[Coefficient - 0x4000] * Sign;
+    }
+
+    *iExponent = 1 - Exponent;
+}
+
+static void TestNormalize(int16_t m, int16_t *Coefficient, int16_t *Exponent) {
+    int16_t n = m < 0 ? ~m : m;
+    int16_t e = n == 0 ? 15 : __builtin_clz(n) - (8 * sizeof(int) - 15);
+
+    if (e > 0)
+        *Coefficient = m * TestDSP1ROM(0x21 + e) << 1;
+    else
+        *Coefficient = m;
+
+    *Exponent -= e;
+}
+
+static int16_t TestTruncate(int16_t C, int16_t E) {
+    if (E > 0) {
+        if (C > 0) return 32767;
+        if (C < 0) return -32767;
+    } else if (E < 0) {
+        return C * TestDSP1ROM(0x0031 + E) >> 15;
+    }
+    return C;
+}
+
+// The Op02 state an Op0A raster line depends on
+struct TestRasterState {
+    int16_t SinAzs, VOffset, VPlane_C, VPlane_E;
+    int16_t SecAZS_C2, SecAZS_E2, SinAas, CosAas;
+};
+
+typedef void (*TestInverseFunc)(int16_t, int16_t, int16_t *, int16_t *);
+
+static void TestRaster(const TestRasterState &s, TestInverseFunc inverse, int16_t Vs, int16_t out[4]) {
+    int16_t C, E, C1, E1;
+
+    inverse((Vs * s.SinAzs >> 15) + s.VOffset, 7, &C, &E);
+    E += s.VPlane_E;
+
+    C1 = C * s.VPlane_C >> 15;
+    E1 = E + s.SecAZS_E2;
+
+    TestNormalize(C1, &C, &E);
+    C = TestTruncate(C, E);
+    out[0] = C * s.CosAas >> 15;
+    out[2] = C * s.SinAas >> 15;
+
+    TestNormalize(C1 * s.SecAZS_C2 >> 15, &C, &E1);
+    C = TestTruncate(C, E1);
+    out[1] = C * -s.SinAas >> 15;
+    out[3] = C * s.CosAas >> 15;
+}
+
+static int16_t TestRandomWord() {
+    return (int16_t)(rand() & 0xffff);
+}
+
+// Tests for the DSP-1 fast paths
+TEST(dsp1_inverse_table_matches_newton) {
+    TestBuildInverseTable();
+
+    for (int c = -32768; c < 32768; c++) {
+        for (int e = -16; e <= 16; e += 4) {
+            int16_t c1, e1, c2, e2;
+            TestInverseNewton(c, e, &c1, &e1);
+            TestInverseTableDriven(c, e, &c2, &e2);
+            ASSERT_EQ(c1, c2);
+            ASSERT_EQ(e1, e2);
+        }
+    }
+}
+
+TEST(dsp1_inverse_special_cases) {
+    TestBuildInverseTable();
+
+    int16_t c, e;
+    TestInverseTableDriven(0, 0, &c, &e);
+    ASSERT_EQ(0x7fff, c);
+    ASSERT_EQ(0x002f, e);
+
+    TestInverseTableDriven(0x4000, 0, &c, &e);
+    ASSERT_EQ(0x7fff, c);
+    ASSERT_EQ(1, e);
+
+    TestInverseTableDriven(-0x4000, 0, &c, &e);
+    ASSERT_EQ(-0x4000, c);
+    ASSERT_EQ(2, e);
+
+    // -32768 is clamped to -32767 before the inverse
+    int16_t c1, e1;
+    TestInverseTableDriven(-32768, 3, &c, &e);
+    TestInverseNewton(-32767, 3, &c1, &e1);
+    ASSERT_EQ(c1, c);
+    ASSERT_EQ(e1, e);
+}
+
+TEST(dsp1_raster_table_matches_newton) {
+    TestBuildInverseTable();
+    srand(1234);
+
+    for (int frame = 0; frame < 500; frame++) {
+        TestRasterState s;
+        s.SinAzs = TestRandomWord();
+        s.VOffset = TestRandomWord();
+        s.VPlane_C = TestRandomWord();
+        s.VPlane_E = rand() % 32 - 16;
+        s.SecAZS_C2 = TestRandomWord();
+        s.SecAZS_E2 = rand() % 32 - 16;
+        s.SinAas = TestRandomWord();
+        s.CosAas = TestRandomWord();
+
+        // a screen's worth of lines
+        int16_t Vs = TestRandomWord();
+        for (int line = 0; line < 225; line++) {
+            int16_t expected[4], actual[4];
+            TestRaster(s, TestInverseNewton, Vs, expected);
+            TestRaster(s, TestInverseTableDriven, Vs, actual);
+            for (int i = 0; i < 4; i++)
+                ASSERT_EQ(expected[i], actual[i]);
+            Vs++;
+        }
+    }
+}
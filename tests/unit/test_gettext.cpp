@@ -0,0 +1,215 @@
+#include "../framework/simple_test.h"
+#include "../mocks/mock_libogc.h"
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+// Test the perfect hash translation tables (buildtools/langtab.c and
+// utils/gettext.cpp, layout in utils/langtab.h)
+
+#define TEST_LANGTAB_HEADER_SIZE 16
+
+static uint32_t TestLangHash(const char *str) {
+    uint32_t hval = 0, g;
+    while (*str != '\0') {
+        hval <<= 4;
+        hval += (unsigned char)*str++;
+        g = hval & ((uint32_t)0xf << 28);
+        if (g != 0) {
+            hval ^= g >> 24;
+            hval ^= g;
+        }
+    }
+    return hval;
+}
+
+static uint32_t TestLangMix(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    x ^= x >> 16;
+    return x;
+}
+
+static uint32_t TestLangBucket(uint32_t id, uint32_t buckets) {
+    return TestLangMix(id) % buckets;
+}
+
+static uint32_t TestLangSlot(uint32_t id, uint32_t disp, uint32_t slots) {
+    return TestLangMix(id ^ (disp * 0x9e3779b9 + 0x6a09e667)) & (slots - 1);
+}
+
+static uint32_t TestRead32(const unsigned char *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void TestWrite32(std::vector<unsigned char> &t, size_t pos, uint32_t v) {
+    t[pos] = v >> 24;
+    t[pos + 1] = v >> 16;
+    t[pos + 2] = v >> 8;
+    t[pos + 3] = v;
+}
+
+struct TestMsg {
+    uint32_t id;
+    std::string msgstr;
+};
+
+// Builds a table the way langtab.c does; returns false if no displacement
+// was found for a bucket
+static bool TestBuildTable(const std::vector<TestMsg> &msgs, std::vector<unsigned char> &table) {
+    uint32_t n = msgs.size();
+    uint32_t buckets = n / 4 + 1;
+    uint32_t slots = 1;
+    while (slots < n)
+        slots <<= 1;
+
+    std::vector<std::vector<int> > members(buckets);
+    for (uint32_t j = 0; j < n; j++)
+        members[TestLangBucket(msgs[j].id, buckets)].push_back(j);
+
+    std::vector<uint32_t> order;
+    for (uint32_t b = 0; b < buckets; b++)
+        order.push_back(b);
+    for (size_t a = 0; a < order.size(); a++)
+        for (size_t b = a + 1; b < order.size(); b++)
+            if (members[order[b]].size() > members[order[a]].size())
+                std::swap(order[a], order[b]);
+
+    std::vector<int> slotMsg(slots, -1);
+    std::vector<uint32_t> disp(buckets, 0);
+
+    for (size_t o = 0; o < order.size(); o++) {
+        const std::vector<int> &m = members[order[o]];
+        if (m.empty())
+            break;
+
+        uint32_t d;
+        for (d = 0; d < (1 << 24); d++) {
+            std::vector<uint32_t> used;
+            bool ok = true;
+            for (size_t k = 0; k < m.size() && ok; k++) {
+                uint32_t s = TestLangSlot(msgs[m[k]].id, d, slots);
+                if (slotMsg[s] >= 0)
+                    ok = false;
+                for (size_t u = 0; u < used.size() && ok; u++)
+                    if (used[u] == s)
+                        ok = false;
+                used.push_back(s);
+            }
+            if (ok)
+                break;
+        }
+        if (d == (1 << 24))
+            return false;
+
+        disp[order[o]] = d;
+        for (size_t k = 0; k < m.size(); k++)
+            slotMsg[TestLangSlot(msgs[m[k]].id, d, slots)] = m[k];
+    }
+
+    size_t strings = TEST_LANGTAB_HEADER_SIZE + buckets * 4 + slots * 8;
+    table.assign(strings, 0);
+    TestWrite32(table, 0, 0x4C414E47);
+    TestWrite32(table, 4, n);
+    TestWrite32(table, 8, buckets);
+    TestWrite32(table, 12, slots);
+    for (uint32_t b = 0; b < buckets; b++)
+        TestWrite32(table, TEST_LANGTAB_HEADER_SIZE + b * 4, disp[b]);
+
+    for (uint32_t i = 0; i < slots; i++) {
+        if (slotMsg[i] < 0)
+            continue;
+        size_t entry = TEST_LANGTAB_HEADER_SIZE + buckets * 4 + i * 8;
+        TestWrite32(table, entry, msgs[slotMsg[i]].id);
+        TestWrite32(table, entry + 4, table.size());
+        const std::string &s = msgs[slotMsg[i]].msgstr;
+        table.insert(table.end(), s.begin(), s.end());
+        table.push_back(0);
+    }
+    return true;
+}
+
+// One probe, as findMSG() in gettext.cpp
+static const char *TestLookup(const std::vector<unsigned char> &table, const char *msgid) {
+    const unsigned char *t = &table[0];
+    uint32_t buckets = TestRead32(t + 8);
+    uint32_t slots = TestRead32(t + 12);
+    uint32_t id = TestLangHash(msgid);
+
+    uint32_t disp = TestRead32(t + TEST_LANGTAB_HEADER_SIZE + TestLangBucket(id, buckets) * 4);
+    const unsigned char *entry = t + TEST_LANGTAB_HEADER_SIZE + buckets * 4 + TestLangSlot(id, disp, slots) * 8;
+    uint32_t offset = TestRead32(entry + 4);
+
+    if (offset == 0 || TestRead32(entry) != id)
+        return NULL;
+    return (const char *)t + offset;
+}
+
+static std::string TestMsgid(int i) {
+    char buf[64];
+    sprintf(buf, "Menu label number %d", i);
+    return buf;
+}
+
+// Tests for the translation tables
+TEST(langtab_finds_every_msgid) {
+    for (int n = 0; n < 600; n += 37) {
+        std::vector<TestMsg> msgs;
+        for (int i = 0; i < n; i++) {
+            TestMsg m;
+            m.id = TestLangHash(TestMsgid(i).c_str());
+            m.msgstr = "translated " + TestMsgid(i);
+            msgs.push_back(m);
+        }
+
+        std::vector<unsigned char> table;
+        ASSERT_TRUE(TestBuildTable(msgs, table));
+        ASSERT_EQ((uint32_t)n, TestRead32(&table[4]));
+
+        for (int i = 0; i < n; i++) {
+            const char *s = TestLookup(table, TestMsgid(i).c_str());
+            ASSERT_NOT_NULL(s);
+            ASSERT_STREQ(msgs[i].msgstr.c_str(), s);
+        }
+    }
+}
+
+TEST(langtab_misses_untranslated_msgids) {
+    std::vector<TestMsg> msgs;
+    for (int i = 0; i < 300; i++) {
+        TestMsg m;
+        m.id = TestLangHash(TestMsgid(i).c_str());
+        m.msgstr = "x";
+        msgs.push_back(m);
+    }
+
+    std::vector<unsigned char> table;
+    ASSERT_TRUE(TestBuildTable(msgs, table));
+
+    for (int i = 300; i < 3000; i++)
+        ASSERT_NULL(TestLookup(table, TestMsgid(i).c_str()));
+}
+
+TEST(langtab_empty_language) {
+    std::vector<TestMsg> msgs;
+    std::vector<unsigned char> table;
+    ASSERT_TRUE(TestBuildTable(msgs, table));
+    ASSERT_EQ((size_t)(TEST_LANGTAB_HEADER_SIZE + 4 + 8), table.size());
+    ASSERT_NULL(TestLookup(table, "Settings"));
+}
+
+TEST(langtab_hash_matches_hashpjw) {
+    // values of the hash the .lang ids were always looked up with
+    ASSERT_EQ(0u, TestLangHash(""));
+    ASSERT_EQ(0x61u, TestLangHash("a"));
+    ASSERT_EQ(0x672u, TestLangHash("ab"));
+
+    // the high nibble is folded back in
+    uint32_t h = TestLangHash("abcdefgh");
+    ASSERT_EQ(0u, h & 0xf0000000);
+}
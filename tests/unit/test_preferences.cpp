@@ -321,4 +321,81 @@ TEST(validate_network_settings_incomplete) {
 TEST(validate_network_settings_null_input) {
     bool valid = TestValidateNetworkSettings(nullptr);
     ASSERT_FALSE(valid);
-}
\ No newline at end of file
+}
+
+// Per-game profile index (gameprofile.cpp): entries sorted by ROM CRC
+
+struct TestGameProfile {
+    unsigned int crc;
+    signed char FilterMethod;
+};
+
+// Binary search - returns the index of crc or -1, pos is the insert position
+int TestFindProfile(const TestGameProfile* profiles, int count, unsigned int crc, int* pos) {
+    int lo = 0, hi = count;
+
+    while (lo < hi) {
+        int mid = (lo + hi) >> 1;
+
+        if (profiles[mid].crc < crc)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if (pos)
+        *pos = lo;
+
+    return (lo < count && profiles[lo].crc == crc) ? lo : -1;
+}
+
+void TestInsertProfile(TestGameProfile* profiles, int* count, unsigned int crc, signed char filter) {
+    int pos;
+
+    if (TestFindProfile(profiles, *count, crc, &pos) >= 0)
+        return;
+
+    memmove(&profiles[pos + 1], &profiles[pos], (*count - pos) * sizeof(TestGameProfile));
+    profiles[pos].crc = crc;
+    profiles[pos].FilterMethod = filter;
+    (*count)++;
+}
+
+TEST(game_profile_insert_keeps_order) {
+    TestGameProfile profiles[8];
+    int count = 0;
+    const unsigned int crcs[] = { 0xB19ED489, 0x0F34A2C1, 0xFFFFFFFF, 0x00000000, 0x7A1C3E22 };
+
+    for (int i = 0; i < 5; i++)
+        TestInsertProfile(profiles, &count, crcs[i], (signed char)i);
+
+    ASSERT_EQ(count, 5);
+
+    for (int i = 1; i < count; i++)
+        ASSERT_TRUE(profiles[i - 1].crc < profiles[i].crc);
+
+    // inserting an existing CRC doesn't add a duplicate
+    TestInsertProfile(profiles, &count, 0x7A1C3E22, 9);
+    ASSERT_EQ(count, 5);
+}
+
+TEST(game_profile_lookup) {
+    TestGameProfile profiles[8];
+    int count = 0;
+
+    TestInsertProfile(profiles, &count, 0x30000000, 1);
+    TestInsertProfile(profiles, &count, 0x10000000, 2);
+    TestInsertProfile(profiles, &count, 0x20000000, 3);
+
+    int i = TestFindProfile(profiles, count, 0x20000000, nullptr);
+    ASSERT_TRUE(i >= 0);
+    ASSERT_EQ(profiles[i].FilterMethod, 3);
+
+    int pos;
+    ASSERT_EQ(TestFindProfile(profiles, count, 0x15000000, &pos), -1);
+    ASSERT_EQ(pos, 1);
+    ASSERT_EQ(TestFindProfile(profiles, count, 0x40000000, &pos), -1);
+    ASSERT_EQ(pos, 3);
+    ASSERT_EQ(TestFindProfile(profiles, 0, 0x10000000, &pos), -1);
+    ASSERT_EQ(pos, 0);
+}
@@ -0,0 +1,190 @@
+#include "../framework/simple_test.h"
+#include "../mocks/mock_libogc.h"
+#include <cstring>
+#include <cstdlib>
+#include <stdint.h>
+#include <vector>
+
+// Test the save browser thumbnails written and read by screenshot.cpp
+
+#define TEST_THUMB_MAGIC "#!s9xthm"
+#define TEST_THUMB_HEADER 12
+
+// Thumbnail size for a frame, as FitThumb()
+static void TestFitThumb(int width, int height, int maxwidth, int maxheight, int *tw, int *th) {
+    int w = width > 256 ? width / 2 : width;
+    int h = height > 256 ? height / 2 : height;
+
+    if (w > maxwidth || h > maxheight) {
+        float ratio = (float)w / (float)h;
+        *tw = maxwidth;
+        *th = maxwidth / ratio;
+        if (*th > maxheight) {
+            *tw = maxheight * ratio;
+            *th = maxheight;
+        }
+    } else {
+        *tw = w;
+        *th = h;
+    }
+}
+
+static uint8_t TestExpand5(uint8_t v) { return (v << 3) | (v >> 2); }
+static uint8_t TestExpand6(uint8_t v) { return (v << 2) | (v >> 4); }
+
+static uint32_t TestCoordsRGBA8(uint32_t x, uint32_t y, uint32_t w) {
+    return ((((y >> 2) * (w >> 2) + (x >> 2)) << 5) + ((y & 3) << 2) + (x & 3)) << 1;
+}
+
+// Scales the frame and packs the header and big endian pixels, as
+// WriteThumb() does before compressing them
+static std::vector<uint8_t> TestBuildThumb(const uint16_t *frame, int width, int height, int maxw, int maxh) {
+    int tw, th;
+    TestFitThumb(width, height, maxw, maxh, &tw, &th);
+
+    std::vector<uint8_t> out(TEST_THUMB_HEADER);
+    memcpy(&out[0], TEST_THUMB_MAGIC, 8);
+    out[8] = tw >> 8;
+    out[9] = tw;
+    out[10] = th >> 8;
+    out[11] = th;
+
+    int xRatio = (width << 16) / tw + 1;
+    int yRatio = (height << 16) / th + 1;
+    for (int y = 0; y < th; y++) {
+        const uint16_t *src = frame + ((y * yRatio) >> 16) * width;
+        for (int x = 0; x < tw; x++) {
+            uint16_t p = src[(x * xRatio) >> 16];
+            out.push_back(p >> 8);
+            out.push_back(p & 0xff);
+        }
+    }
+    return out;
+}
+
+// Unpacks a thumbnail to padded RGBA8 tiles, as DecodeThumbFromFile()
+static bool TestDecodeThumb(const std::vector<uint8_t> &thumb, int maxw, int maxh, std::vector<uint8_t> &dst, int *w, int *h) {
+    if (thumb.size() <= TEST_THUMB_HEADER || memcmp(&thumb[0], TEST_THUMB_MAGIC, 8) != 0)
+        return false;
+
+    *w = (thumb[8] << 8) | thumb[9];
+    *h = (thumb[10] << 8) | thumb[11];
+    if (*w == 0 || *h == 0 || *w > maxw || *h > maxh)
+        return false;
+    if (thumb.size() != (size_t)(TEST_THUMB_HEADER + *w * *h * 2))
+        return false;
+
+    int padWidth = (*w + 3) & ~3;
+    int padHeight = (*h + 3) & ~3;
+    dst.assign(padWidth * padHeight * 4, 0xcc);
+
+    for (int y = 0; y < padHeight; y++) {
+        for (int x = 0; x < padWidth; x++) {
+            uint32_t o = TestCoordsRGBA8(x, y, padWidth);
+            if (y >= *h || x >= *w) {
+                dst[o] = 0;
+                dst[o + 1] = 255;
+                dst[o + 32] = 255;
+                dst[o + 33] = 255;
+            } else {
+                const uint8_t *src = &thumb[TEST_THUMB_HEADER + (y * *w + x) * 2];
+                uint16_t p = (src[0] << 8) | src[1];
+                dst[o] = 255;
+                dst[o + 1] = TestExpand5((p >> 11) & 0x1f);
+                dst[o + 32] = TestExpand6((p >> 5) & 0x3f);
+                dst[o + 33] = TestExpand5(p & 0x1f);
+            }
+        }
+    }
+    return true;
+}
+
+// Tests for the save browser thumbnails
+TEST(thumb_fit_snes_resolutions) {
+    int w, h;
+
+    // 8:7 frames are limited by the height
+    TestFitThumb(256, 224, 64, 48, &w, &h);
+    ASSERT_EQ(54, w);
+    ASSERT_EQ(48, h);
+
+    TestFitThumb(256, 239, 64, 48, &w, &h);
+    ASSERT_EQ(51, w);
+    ASSERT_EQ(48, h);
+
+    // hi-res and interlaced frames keep the same shape
+    TestFitThumb(512, 448, 64, 48, &w, &h);
+    ASSERT_EQ(54, w);
+    ASSERT_EQ(48, h);
+
+    TestFitThumb(512, 224, 64, 48, &w, &h);
+    ASSERT_EQ(54, w);
+    ASSERT_EQ(48, h);
+
+    // small frames are not scaled up
+    TestFitThumb(32, 16, 64, 48, &w, &h);
+    ASSERT_EQ(32, w);
+    ASSERT_EQ(16, h);
+}
+
+TEST(thumb_rgb565_expands_to_full_range) {
+    ASSERT_EQ(0, TestExpand5(0));
+    ASSERT_EQ(255, TestExpand5(0x1f));
+    ASSERT_EQ(0, TestExpand6(0));
+    ASSERT_EQ(255, TestExpand6(0x3f));
+    ASSERT_EQ(0x84, TestExpand5(0x10));
+    ASSERT_EQ(0x82, TestExpand6(0x20));
+}
+
+TEST(thumb_round_trip_to_tiles) {
+    static uint16_t frame[256 * 224];
+    srand(1357);
+    for (int i = 0; i < 256 * 224; i++)
+        frame[i] = rand() & 0xffff;
+
+    std::vector<uint8_t> thumb = TestBuildThumb(frame, 256, 224, 64, 48);
+    std::vector<uint8_t> tiles;
+    int w, h;
+    ASSERT_TRUE(TestDecodeThumb(thumb, 64, 48, tiles, &w, &h));
+    ASSERT_EQ(54, w);
+    ASSERT_EQ(48, h);
+
+    // every pixel comes from the nearest source pixel
+    int xRatio = (256 << 16) / w + 1;
+    int yRatio = (224 << 16) / h + 1;
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            uint16_t p = frame[((y * yRatio) >> 16) * 256 + ((x * xRatio) >> 16)];
+            uint32_t o = TestCoordsRGBA8(x, y, 56);
+            ASSERT_EQ(255, tiles[o]);
+            ASSERT_EQ(TestExpand5(p >> 11), tiles[o + 1]);
+            ASSERT_EQ(TestExpand6((p >> 5) & 0x3f), tiles[o + 32]);
+            ASSERT_EQ(TestExpand5(p & 0x1f), tiles[o + 33]);
+        }
+    }
+
+    // the padding up to 56 pixels is transparent
+    for (int y = 0; y < h; y++)
+        for (int x = w; x < 56; x++)
+            ASSERT_EQ(0, tiles[TestCoordsRGBA8(x, y, 56)]);
+}
+
+TEST(thumb_rejects_bad_files) {
+    static uint16_t frame[256 * 224];
+    memset(frame, 0, sizeof(frame));
+    std::vector<uint8_t> tiles;
+    int w, h;
+
+    // larger than the preview it is decoded for
+    std::vector<uint8_t> thumb = TestBuildThumb(frame, 256, 224, 64, 48);
+    ASSERT_TRUE(!TestDecodeThumb(thumb, 32, 32, tiles, &w, &h));
+
+    // a PNG renamed to .thm
+    std::vector<uint8_t> png(thumb);
+    memcpy(&png[0], "\x89PNG\r\n\x1a\n", 8);
+    ASSERT_TRUE(!TestDecodeThumb(png, 64, 48, tiles, &w, &h));
+
+    // truncated
+    std::vector<uint8_t> header(thumb.begin(), thumb.begin() + TEST_THUMB_HEADER);
+    ASSERT_TRUE(!TestDecodeThumb(header, 64, 48, tiles, &w, &h));
+}